@@ -0,0 +1,203 @@
+//  Copyright (c) Herb Sutter
+//  SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+//===========================================================================
+//  Synthetic corpus generator for the cppfront benchmarks
+//
+//  Usage:  generate-corpus <lines> <output.cpp2>
+//
+//  Writes a mixed Cpp1/Cpp2 source file of about <lines> lines, made of
+//  a repeating mix of the kinds of code that stress different stages:
+//
+//    - long Cpp1 passthrough regions           (load, lowering)
+//    - types using metafunctions               (parse, reflection)
+//    - deeply nested expressions               (parse, lowering)
+//    - functions with inspect and contracts    (sema, lowering)
+//
+//  The output is deterministic for a given <lines>, so runs at the
+//  same size are comparable across cppfront versions
+//===========================================================================
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+class corpus_writer
+{
+    std::ofstream out;
+    long          lines = 0;
+
+public:
+    corpus_writer(char const* filename)
+        : out{filename}
+    { }
+
+    auto is_open() const -> bool { return out.is_open(); }
+
+    auto line_count() const -> long { return lines; }
+
+    auto line(std::string const& s)
+        -> void
+    {
+        out << s << "\n";
+        ++lines;
+    }
+
+
+    //  A run of ordinary Cpp1 code, which should pass through unchanged
+    //
+    auto cpp1_region(int i)
+        -> void
+    {
+        auto n = std::to_string(i);
+        line("// Cpp1 region " + n);
+        line("namespace cpp1_region_" + n + " {");
+        line("");
+        line("struct record {");
+        line("    int         id    = " + n + ";");
+        line("    double      score = 0.0;");
+        line("    const char* name  = \"record " + n + "\";");
+        line("};");
+        line("");
+        for (auto f = 0; f < 4; ++f) {
+            auto fn = std::to_string(f);
+            line("/* helper " + fn + " of region " + n + " */");
+            line("inline int helper_" + fn + "(int x, int y) {");
+            line("    int total = 0;");
+            line("    for (int k = 0; k < x; ++k) {");
+            line("        if ((k ^ y) & 1) { total += k * " + fn + "; }");
+            line("        else             { total -= y; }");
+            line("    }");
+            line("    return total;");
+            line("}");
+            line("");
+        }
+        line("}  // namespace cpp1_region_" + n);
+        line("");
+    }
+
+
+    //  A few types whose members are generated by metafunctions
+    //
+    auto metafunction_types(int i)
+        -> void
+    {
+        auto n = std::to_string(i);
+        line("value_" + n + ": @value type = {");
+        line("    val: int = 0;");
+        line("    operator=: (out this, v: int) = { val = v; }");
+        line("    get: (this) -> int = val;");
+        line("}");
+        line("");
+        line("ordered_" + n + ": @ordered type = {");
+        line("    key: int;");
+        line("    operator=: (out this, k: int) = { key = k; }");
+        line("}");
+        line("");
+        line("struct_" + n + ": @struct type = {");
+        line("    a: int = " + n + ";");
+        line("    b: double = 1.5;");
+        line("    c: std::string = \"struct " + n + "\";");
+        line("}");
+        line("");
+        line("shape_" + n + ": @interface type = {");
+        line("    area: (this) -> double;");
+        line("    scale: (inout this, factor: double);");
+        line("}");
+        line("");
+    }
+
+
+    //  A function whose body is one deeply nested expression
+    //
+    auto deep_expression(int i)
+        -> void
+    {
+        auto n    = std::to_string(i);
+        auto expr = std::string{"x"};
+        for (auto d = 0; d < 24; ++d) {
+            auto ops = "+-*|&^";
+            expr = "(" + expr + " " + ops[d % 6] + " " + std::to_string(d + 1) + ")";
+        }
+        line("deep_" + n + ": (x: int) -> int = {");
+        line("    y: int = " + expr + ";");
+        line("    return y * 2 + (x % 7) - (y / (x + 1) + 3);");
+        line("}");
+        line("");
+    }
+
+
+    //  A function that uses inspect, contracts, and definite initialization
+    //
+    auto inspect_and_contracts(int i)
+        -> void
+    {
+        auto n = std::to_string(i);
+        line("classify_" + n + ": (v: _) -> std::string = {");
+        line("    return inspect v -> std::string {");
+        line("        is int         = \"int \" + std::to_string(v as int);");
+        line("        is double      = \"double\";");
+        line("        is std::string = \"string\";");
+        line("        is _           = \"other\";");
+        line("    };");
+        line("}");
+        line("");
+        line("checked_" + n + ": (inout vec: std::vector<int>, where: int, val: int)");
+        line("    [[pre:  0 <= where && where <= std::ssize(vec)]]");
+        line("    [[post: 0 <= where$]]");
+        line("= {");
+        line("    result: int;");
+        line("    if where < std::ssize(vec) {");
+        line("        result = vec[where] + val;");
+        line("    }");
+        line("    else {");
+        line("        result = val;");
+        line("    }");
+        line("    [[assert: result == result]]");
+        line("    _ = vec.insert( vec.begin() + where, result );");
+        line("}");
+        line("");
+    }
+};
+
+
+auto main(int argc, char* argv[])
+    -> int
+{
+    if (argc != 3) {
+        std::cerr << "usage: generate-corpus <lines> <output.cpp2>\n";
+        return EXIT_FAILURE;
+    }
+
+    auto target = std::atol(argv[1]);
+    auto out    = corpus_writer{argv[2]};
+    if (!out.is_open()) {
+        std::cerr << "could not open " << argv[2] << "\n";
+        return EXIT_FAILURE;
+    }
+
+    out.line("#include <string>");
+    out.line("#include <vector>");
+    out.line("");
+
+    for (auto i = 0; out.line_count() < target; ++i) {
+        out.cpp1_region(i);
+        out.metafunction_types(i);
+        out.deep_expression(i);
+        out.inspect_and_contracts(i);
+    }
+
+    out.line("main: () -> int = {");
+    out.line("    return deep_0(1) % 2;");
+    out.line("}");
+}
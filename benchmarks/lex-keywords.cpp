@@ -0,0 +1,191 @@
+//  Copyright (c) Herb Sutter
+//  SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+//===========================================================================
+//  Micro-benchmark for keyword recognition in the lexer
+//
+//  Usage:  lex-keywords <files.cpp2...>
+//
+//  For every identifier-like word in the Cpp2 sections of the files, this
+//  times classifying it with the lexer's perfect-hash keyword_table, and
+//  with the linear scan over keyword lists that it replaced (kept here as
+//  the reference, which also checks that the two always agree). Then it
+//  times lexing the whole files.
+//===========================================================================
+
+#include "../source/lex.h"
+#include "print.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+using namespace cpp2;
+
+//  The linear scan lex_line used to do: the first list entry that the
+//  word starts with, checked in turn against each of these lists
+//
+auto linear_scan_keyword(std::string_view word)
+    -> std::optional<lexeme>
+{
+    static const auto multi_keys = std::vector<std::string_view>{
+        "char16_t", "char32_t", "char8_t", "char", "double", "float", "int", "long", "short", "signed", "unsigned"
+    };
+    static const auto fixed_keys = std::vector<std::string_view>{
+        "i8", "i16", "i32", "i64", "longdouble", "longlong", "u8", "u16", "u32", "u64", "ulong", "ulonglong", "ushort"
+    };
+    static const auto keys = std::vector<std::string_view>{
+        "alignas", "alignof", "asm", "as", "auto",
+        "bool", "break",
+        "case", "catch", "char16_t", "char32_t", "char8_t", "char", "co_await", "co_return",
+        "co_yield", "concept", "const_cast", "consteval", "constexpr", "constinit", "const", "continue",
+        "decltype", "default", "double", "do", "dynamic_cast",
+        "else", "enum", "explicit", "export", "extern",
+        "float", "for", "friend",
+        "goto",
+        "if", "import", "inline", "int", "is",
+        "long",
+        "module", "mutable",
+        "namespace", "noexcept",
+        "operator",
+        "private", "protected", "public",
+        "register", "reinterpret_cast", "requires", "return",
+        "short", "signed", "sizeof", "static_assert", "static_cast", "static", "switch",
+        "template", "this", "thread_local", "throws", "throw", "try", "typedef", "typeid", "typename",
+        "unsigned", "using",
+        "virtual", "void", "volatile",
+        "wchar_t", "while"
+    };
+
+    auto matches = [&](std::vector<std::string_view> const& r) {
+        auto m = std::find_if(r.begin(), r.end(), [&](std::string_view s) {
+            return word.starts_with(s);
+        });
+        return m != r.end() && m->size() == word.size();
+    };
+
+    if (matches(multi_keys)) { return lexeme::Cpp1MultiKeyword; }
+    if (matches(fixed_keys)) { return lexeme::Cpp2FixedType;    }
+    if (matches(keys))       { return lexeme::Keyword;          }
+    return {};
+}
+
+auto perfect_hash_keyword(std::string_view word)
+    -> std::optional<lexeme>
+{
+    if (auto k = keywords.lookup(word)) {
+        return k->type;
+    }
+    return {};
+}
+
+
+auto main(int argc, char* argv[])
+    -> int
+{
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+
+    //  Collect the words
+    auto errors  = std::vector<error_entry>{};
+    auto sources = std::deque<source>{};
+    auto words   = std::vector<std::string_view>{};
+    auto lines   = 0L;
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto& src = sources.emplace_back(errors);
+        if (!src.load(argv[i])) {
+            std::cerr << "could not load " << argv[i] << "\n";
+            return EXIT_FAILURE;
+        }
+        lines += std::ssize(src.get_lines()) - 1;
+        for (auto const& line : src.get_lines()) {
+            if (line.cat != source_line::category::cpp2) {
+                continue;
+            }
+            auto text = line.text;
+            for (auto j = 0; j < std::ssize(text); )
+            {
+                auto k = j;
+                while (k < std::ssize(text) && is_identifier_continue(text[k])) {
+                    ++k;
+                }
+                if (k > j) {
+                    words.push_back(text.substr(j, k-j));
+                    j = k;
+                }
+                else {
+                    ++j;
+                }
+            }
+        }
+    }
+    if (words.empty()) {
+        std::cerr << "usage: lex-keywords <files.cpp2...>\n";
+        return EXIT_FAILURE;
+    }
+
+    //  Check that both ways agree
+    auto keyword_count = 0;
+    for (auto word : words) {
+        auto expected = linear_scan_keyword(word);
+        if (perfect_hash_keyword(word) != expected) {
+            std::cerr << "keyword_table disagrees with the linear scan for '" << word << "'\n";
+            return EXIT_FAILURE;
+        }
+        keyword_count += expected.has_value();
+    }
+
+    //  Time each way
+    constexpr auto passes = 50;
+    auto time_classify = [&](auto classify) {
+        auto found = 0;
+        auto start = clock::now();
+        for (auto pass = 0; pass < passes; ++pass) {
+            for (auto word : words) {
+                found += classify(word).has_value();
+            }
+        }
+        auto elapsed = clock::now() - start;
+        if (found != keyword_count * passes) {
+            std::cerr << "unexpected keyword count\n";
+        }
+        return elapsed / passes;
+    };
+    auto linear  = time_classify(linear_scan_keyword);
+    auto hashed  = time_classify(perfect_hash_keyword);
+
+    std::cout << words.size() << " words (" << keyword_count << " keywords) in "
+              << argc-1 << " files, " << lines << " lines\n";
+    std::cout << "   classify words, linear scan:   " << ms(linear) << " ms\n";
+    std::cout << "   classify words, perfect hash:  " << ms(hashed) << " ms  ("
+              << ms(linear) / ms(hashed) << "x faster)\n";
+
+    //  Time lexing the files (reloading each time, since lexing can rewrite lines)
+    auto lex_time = clock::duration{};
+    for (auto pass = 0; pass < passes; ++pass)
+    {
+        for (auto i = 1; i < argc; ++i)
+        {
+            auto src = source{errors};
+            src.load(argv[i]);
+            auto toks  = tokens{errors};
+            auto start = clock::now();
+            toks.lex(src.get_lines());
+            lex_time += clock::now() - start;
+        }
+        reset_generated_storage();
+    }
+    std::cout << "   lex files:                     " << ms(lex_time / passes) << " ms  ("
+              << __as<double>(lines) / ms(lex_time / passes) << " Klines/s)\n";
+}
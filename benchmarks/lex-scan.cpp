@@ -0,0 +1,174 @@
+//  Copyright (c) Herb Sutter
+//  SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+//===========================================================================
+//  Fuzz check and micro-benchmark for the lexer's run scanning
+//
+//  Usage:  lex-scan [iterations] [files.cpp2...]
+//
+//  Compares each skip_* function in common.h, which scan a block of
+//  characters at a time where they can, against the one-character-at-a-
+//  time loops over the character class predicates that they replaced
+//  (kept here as the reference), on random strings at random positions.
+//  Then, if files are given, it times the two ways over every run of
+//  each class in the files' Cpp2 lines, and times lexing the files.
+//===========================================================================
+
+#include "../source/lex.h"
+#include "print.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace cpp2;
+
+auto reference_skip(std::string_view s, int pos, auto in_run)
+    -> int
+{
+    while (pos < std::ssize(s) && in_run(s[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+struct scanner {
+    std::string_view name;
+    int            (*fast)(std::string_view, int);
+    bool           (*in_run)(char);
+};
+
+static auto const scanners = std::vector<scanner>{
+    { "identifier",     skip_identifier_continue, [](char c) { return is_identifier_continue(c); } },
+    { "whitespace",     skip_whitespace,          [](char c) { return isspace(c) != 0; } },
+    { "digits",         skip_digits,              [](char c) { return is_separator_or(is_digit, c); } },
+    { "hex digits",     skip_hexadecimal_digits,  [](char c) { return is_separator_or(is_hexadecimal_digit, c); } },
+    { "string chars",   skip_plain_string_chars,  [](char c) { return c != '"' && c != '\\' && c != '\0'; } },
+};
+
+
+auto main(int argc, char* argv[])
+    -> int
+{
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+
+    auto iterations = argc > 1 ? std::atoi(argv[1]) : 100'000;
+
+    //  Fuzz: random strings, mostly from one class's alphabet so the runs
+    //  are long enough to cross blocks, with some of every byte value
+    static auto const alphabets = std::vector<std::string>{
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789",
+        " \t\n\v\f\r",
+        "0123456789'",
+        "0123456789abcdefABCDEF'",
+        "abc \"\\$()",
+        "@[`{/:\x7f\x80\xff\x01\x1f"
+    };
+    auto rng = std::mt19937{42};
+    auto s   = std::string{};
+    for (auto n = 0; n < iterations; ++n)
+    {
+        auto const& alphabet = alphabets[rng() % alphabets.size()];
+        s.resize(rng() % 80);
+        for (auto& c : s) {
+            c = rng() % 16 == 0
+                ? char(rng() % 256)
+                : alphabet[rng() % alphabet.size()];
+        }
+        auto pos = s.empty() ? 0 : int(rng() % (s.size() + 1));
+
+        for (auto const& scan : scanners) {
+            auto expected = reference_skip(s, pos, scan.in_run);
+            if (auto got = scan.fast(s, pos); got != expected) {
+                std::cerr << "skip " << scan.name << " from " << pos << " returned " << got
+                          << " instead of " << expected << " on \"" << s << "\"\n";
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    std::cout << iterations << " random strings: all scanners agree with the reference\n";
+
+    //  Time each way over the files
+    auto errors  = std::vector<error_entry>{};
+    auto sources = std::deque<source>{};
+    auto texts   = std::vector<std::string_view>{};
+    for (auto i = 2; i < argc; ++i)
+    {
+        auto& src = sources.emplace_back(errors);
+        if (!src.load(argv[i])) {
+            std::cerr << "could not load " << argv[i] << "\n";
+            return EXIT_FAILURE;
+        }
+        for (auto const& line : src.get_lines()) {
+            if (line.cat == source_line::category::cpp2) {
+                texts.push_back(line.text);
+            }
+        }
+    }
+    if (texts.empty()) {
+        return EXIT_SUCCESS;
+    }
+
+    constexpr auto passes = 20;
+    for (auto const& scan : scanners)
+    {
+        auto time_scan = [&](auto skip) {
+            auto total = 0L;
+            auto start = clock::now();
+            for (auto pass = 0; pass < passes; ++pass) {
+                for (auto text : texts) {
+                    for (auto pos = 0; pos < std::ssize(text); ) {
+                        if (!scan.in_run(text[pos])) {
+                            ++pos;
+                            continue;
+                        }
+                        auto end = skip(text, pos);
+                        total += end - pos;
+                        pos = end;
+                    }
+                }
+            }
+            return std::pair{ (clock::now() - start) / passes, total };
+        };
+        auto [reference, reference_total] = time_scan([&](std::string_view text, int pos) {
+            return reference_skip(text, pos, scan.in_run);
+        });
+        auto [fast, fast_total] = time_scan(scan.fast);
+        if (fast_total != reference_total) {
+            std::cerr << "skip " << scan.name << " disagrees with the reference on the files\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "   skip " << std::setw(14) << std::left << scan.name
+                  << "reference " << ms(reference) << " ms, fast " << ms(fast) << " ms  ("
+                  << ms(reference) / ms(fast) << "x)\n";
+    }
+
+    //  Time lexing the files (reloading each time, since lexing can rewrite lines)
+    auto lex_time = clock::duration{};
+    for (auto pass = 0; pass < passes; ++pass)
+    {
+        for (auto i = 2; i < argc; ++i)
+        {
+            auto src = source{errors};
+            src.load(argv[i]);
+            auto toks  = tokens{errors};
+            auto start = clock::now();
+            toks.lex(src.get_lines());
+            lex_time += clock::now() - start;
+        }
+        reset_generated_storage();
+    }
+    std::cout << "   lex files:  " << ms(lex_time / passes) << " ms\n";
+}
@@ -0,0 +1,175 @@
+//  Copyright (c) Herb Sutter
+//  SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+//===========================================================================
+//  Benchmark for building and destroying parse trees
+//
+//  Usage:  parse-nodes <files.cpp2...>
+//
+//  Lexes the files, then repeatedly parses them and destroys the parse
+//  trees, timing each, and reports how many nodes the trees have, the
+//  memory the nodes take in the node_arena, and how many heap allocations
+//  building a tree takes in all (nodes, and the vectors and strings in
+//  them), counted by replacing the global operator new
+//
+//  Then does the same parsing with deferred function bodies, reporting
+//  the nodes and time up to when the declarations are parsed, and the
+//  time to parse the deferred bodies after that
+//===========================================================================
+
+#include "../source/reflect.h"
+#include "print.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+using namespace cpp2;
+
+static auto heap_allocations = std::int64_t{0};
+
+//  Every form of the global operator new is replaced, so that each one is
+//  counted and each one's memory comes from malloc and goes back to free
+//
+//  The operator deletes are kept out of line, since when one is inlined
+//  into code that got its pointer from operator new, GCC's -Wall warns
+//  about a mismatched allocation function (-Wmismatched-new-delete) even
+//  though the replacement pairs are consistent
+//
+auto counted_allocation(
+    std::size_t size,
+    std::size_t alignment = 0
+)
+    -> void*
+{
+    ++heap_allocations;
+    size = size == 0 ? 1 : size;
+    auto p = alignment == 0
+        ? std::malloc(size)
+        : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (!p) {
+        throw std::bad_alloc{};
+    }
+    return p;
+}
+
+auto operator new  (std::size_t size)                        -> void* { return counted_allocation(size); }
+auto operator new[](std::size_t size)                        -> void* { return counted_allocation(size); }
+auto operator new  (std::size_t size, std::align_val_t al)   -> void* { return counted_allocation(size, std::size_t(al)); }
+auto operator new[](std::size_t size, std::align_val_t al)   -> void* { return counted_allocation(size, std::size_t(al)); }
+
+[[gnu::noinline]] auto operator delete  (void* p) noexcept                                     -> void { std::free(p); }
+[[gnu::noinline]] auto operator delete[](void* p) noexcept                                     -> void { std::free(p); }
+[[gnu::noinline]] auto operator delete  (void* p, std::size_t) noexcept                        -> void { std::free(p); }
+[[gnu::noinline]] auto operator delete[](void* p, std::size_t) noexcept                        -> void { std::free(p); }
+[[gnu::noinline]] auto operator delete  (void* p, std::align_val_t) noexcept                   -> void { std::free(p); }
+[[gnu::noinline]] auto operator delete[](void* p, std::align_val_t) noexcept                   -> void { std::free(p); }
+[[gnu::noinline]] auto operator delete  (void* p, std::size_t, std::align_val_t) noexcept      -> void { std::free(p); }
+[[gnu::noinline]] auto operator delete[](void* p, std::size_t, std::align_val_t) noexcept      -> void { std::free(p); }
+
+auto main(int argc, char* argv[])
+    -> int
+{
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+
+    //  Lex the files once
+    auto errors  = std::vector<error_entry>{};
+    auto sources = std::deque<source>{};
+    auto lexed   = std::deque<tokens>{};
+    auto lines   = 0L;
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto& src = sources.emplace_back(errors);
+        if (!src.load(argv[i])) {
+            std::cerr << "could not load " << argv[i] << "\n";
+            return EXIT_FAILURE;
+        }
+        lines += std::ssize(src.get_lines()) - 1;
+        lexed.emplace_back(errors).lex(src.get_lines());
+    }
+    if (lexed.empty()) {
+        std::cerr << "usage: parse-nodes <files.cpp2...>\n";
+        return EXIT_FAILURE;
+    }
+
+    //  Parse them all and destroy the trees, several times
+    constexpr auto passes = 10;
+    struct results {
+        clock::duration         parse_time   = {};
+        clock::duration         bodies_time  = {};
+        clock::duration         destroy_time = {};
+        std::int64_t            allocations  = 0;
+        node_arena::statistics  stats        = {};
+    };
+    auto run = [&](bool defer_bodies) {
+        auto ret = results{};
+        for (auto pass = 0; pass < passes; ++pass)
+        {
+            auto parsers = std::deque<parser>{};
+            auto start   = clock::now();
+            auto before  = heap_allocations;
+            for (auto& toks : lexed) {
+                auto& p = parsers.emplace_back(errors);
+                for (auto const& section : toks.get_sections()) {
+                    try {
+                        p.parse(toks.get_tokens(section), toks.get_generated(), defer_bodies);
+                    }
+                    catch (std::runtime_error const&) {
+                        //  as in cppfront, a parse can end with an exception
+                        //  for some errors (e.g., ones found by metafunctions)
+                    }
+                }
+            }
+            ret.parse_time  += clock::now() - start;
+            ret.allocations  = heap_allocations - before;
+            ret.stats        = parse_nodes.get_statistics();
+
+            if (defer_bodies) {
+                start = clock::now();
+                for (auto& p : parsers) {
+                    try {
+                        p.parse_deferred_function_bodies(parser::default_parallel_min_bodies, [](int, bool) {});
+                    }
+                    catch (std::runtime_error const&) { }
+                }
+                ret.bodies_time += clock::now() - start;
+            }
+
+            start = clock::now();
+            parsers.clear();
+            ret.destroy_time += clock::now() - start;
+        }
+        return ret;
+    };
+
+    auto all      = run(false);
+    auto deferred = run(true);
+    if (!errors.empty()) {
+        std::cerr << "the files had " << errors.size() << " errors\n";
+    }
+
+    std::cout << argc-1 << " files, " << lines << " lines\n";
+    std::cout << "   parse tree nodes:      " << all.stats.nodes << "  ("
+              << all.stats.bytes / 1024 << " KiB, in " << all.stats.blocks << " arena blocks)\n";
+    std::cout << "   heap allocations:      " << all.allocations << " per parse  ("
+              << __as<double>(all.allocations) / __as<double>(all.stats.nodes) << " per node)\n";
+    std::cout << "   parse:                 " << ms(all.parse_time / passes) << " ms\n";
+    std::cout << "   destroy parse trees:   " << ms(all.destroy_time / passes) << " ms\n";
+    std::cout << "   with deferred function bodies:\n";
+    std::cout << "     declarations' nodes: " << deferred.stats.nodes << "  ("
+              << deferred.stats.bytes / 1024 << " KiB)\n";
+    std::cout << "     parse declarations:  " << ms(deferred.parse_time / passes) << " ms\n";
+    std::cout << "     then parse bodies:   " << ms(deferred.bodies_time / passes) << " ms\n";
+}
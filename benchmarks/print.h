@@ -0,0 +1,34 @@
+//  Copyright (c) Herb Sutter
+//  SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+//===========================================================================
+//  What every benchmark program that uses cppfront's headers must define
+//===========================================================================
+
+#ifndef __CPP2_BENCHMARKS_PRINT
+#define __CPP2_BENCHMARKS_PRINT
+
+#include "../source/common.h"
+#include <iomanip>
+#include <iostream>
+
+//  common.h leaves printing to the program (see cppfront.cpp)
+auto cpp2::cmdline_processor::print(std::string_view s, int width)
+    -> void
+{
+    if (width > 0) {
+        std::cout << std::setw(width) << std::left;
+    }
+    std::cout << s;
+}
+
+#endif
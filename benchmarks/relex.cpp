@@ -0,0 +1,199 @@
+//  Copyright (c) Herb Sutter
+//  SPDX-License-Identifier: CC-BY-NC-ND-4.0
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+//===========================================================================
+//  Benchmark and check for incremental re-lexing
+//
+//  Usage:  relex <file.cpp2> [edits]
+//
+//  Makes a series of random one-line edits to the Cpp2 code in the file
+//  (typing tokens, and opening and closing comments and raw strings), and
+//  after each one times tokens::relex against lexing the whole file again.
+//  It also checks that the two always give the same tokens, sections,
+//  and comments.
+//===========================================================================
+
+#include "../source/lex.h"
+#include "print.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace cpp2;
+
+//  Compare the results of lexing the same text two ways
+auto same_result(
+    tokens const&                   a,
+    tokens const&                   b,
+    std::vector<source_line> const& a_lines,
+    std::vector<source_line> const& b_lines
+)
+    -> bool
+{
+    auto const& as = a.get_sections();
+    auto const& bs = b.get_sections();
+    if (as.size() != bs.size()) {
+        return false;
+    }
+    for (auto s = 0; s < std::ssize(as); ++s)
+    {
+        auto at = a.get_tokens(as[s]);
+        auto bt = b.get_tokens(bs[s]);
+        if (
+            as[s].lineno != bs[s].lineno
+            || at.size() != bt.size()
+            )
+        {
+            return false;
+        }
+        for (auto t = 0; t < std::ssize(at); ++t) {
+            if (
+                at[t].as_string_view() != bt[t].as_string_view()
+                || at[t].position() != bt[t].position()
+                || at[t].type() != bt[t].type()
+                )
+            {
+                return false;
+            }
+        }
+    }
+
+    auto const& ac = a.get_comments();
+    auto const& bc = b.get_comments();
+    if (ac.size() != bc.size()) {
+        return false;
+    }
+    for (auto c = 0; c < std::ssize(ac); ++c) {
+        if (
+            ac[c].kind != bc[c].kind
+            || ac[c].start != bc[c].start
+            || ac[c].end != bc[c].end
+            || ac[c].text != bc[c].text
+            )
+        {
+            return false;
+        }
+    }
+
+    for (auto l = 0; l < std::ssize(a_lines); ++l) {
+        if (a_lines[l].all_tokens_are_densely_spaced != b_lines[l].all_tokens_are_densely_spaced) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+auto main(int argc, char* argv[])
+    -> int
+{
+    using clock = std::chrono::steady_clock;
+    auto us = [](clock::duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    };
+
+    if (argc < 2) {
+        std::cerr << "usage: relex <file.cpp2> [edits]\n";
+        return EXIT_FAILURE;
+    }
+    auto edit_count = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    auto errors = std::vector<error_entry>{};
+    auto src    = source{errors};
+    if (!src.load(argv[1])) {
+        std::cerr << "could not load " << argv[1] << "\n";
+        return EXIT_FAILURE;
+    }
+
+    //  The lines as loaded, with the edits so far (lexing can rewrite
+    //  a line's text, so each full lex starts from a copy of these)
+    auto const pristine = src.get_lines();
+    auto edited = pristine;
+    auto cpp2_lines = std::vector<int>{};
+    for (auto l = 0; l < std::ssize(edited); ++l) {
+        if (edited[l].cat == source_line::category::cpp2) {
+            cpp2_lines.push_back(l);
+        }
+    }
+    if (cpp2_lines.empty()) {
+        std::cerr << argv[1] << " has no Cpp2 code\n";
+        return EXIT_FAILURE;
+    }
+
+    auto lines = edited;
+    auto toks  = std::make_unique<tokens>(errors);
+    toks->enable_relex();
+    toks->lex(lines);
+
+    static auto const snippets = std::vector<std::string_view>{
+        " x", " 42", " +", " ;", " {", " }", " (", " )", "\"s\"", " 'c'",
+        " int", " unsigned", " long", " operator", " =", "u8",
+        " /*", "*/", " // note", " R\"(", ")\"", " $R\"(", "(x)$"
+    };
+    auto texts = std::deque<std::string>{};
+    auto rng   = std::mt19937{42};
+
+    auto relex_time = clock::duration{};
+    auto lex_time   = clock::duration{};
+    auto fallbacks  = 0;
+    for (auto e = 0; e < edit_count; ++e)
+    {
+        //  Insert a snippet somewhere in a random Cpp2 line
+        auto l        = cpp2_lines[rng() % cpp2_lines.size()];
+        auto old_text = std::string{edited[l].text};
+        auto text     = old_text;
+        text.insert(rng() % (text.size() + 1), snippets[rng() % snippets.size()]);
+        edited[l].text = texts.emplace_back(std::move(text));
+        lines[l].text  = edited[l].text;
+
+        //  Lex the whole file first, and skip edits it rejects (some kinds
+        //  of malformed raw string make lex_line throw)
+        auto fresh_lines = edited;
+        auto fresh       = tokens{errors};
+        auto start       = clock::now();
+        try {
+            fresh.lex(fresh_lines);
+        }
+        catch (std::exception const&) {
+            edited[l].text = lines[l].text = texts.emplace_back(old_text);
+            errors.clear();
+            --e;
+            continue;
+        }
+        lex_time += clock::now() - start;
+
+        start = clock::now();
+        if (!toks->relex(lines, l, l+1)) {
+            ++fallbacks;
+            lines = edited;
+            toks  = std::make_unique<tokens>(errors);
+            toks->enable_relex();
+            toks->lex(lines);
+        }
+        relex_time += clock::now() - start;
+
+        if (!same_result(*toks, fresh, lines, fresh_lines)) {
+            std::cerr << "relex disagrees with lex after edit " << e
+                      << " on line " << l << ": " << edited[l].text << "\n";
+            return EXIT_FAILURE;
+        }
+        errors.clear();
+    }
+
+    std::cout << edit_count << " edits to " << argv[1] << " ("
+              << std::ssize(pristine) - 1 << " lines), "
+              << fallbacks << " needing a full lex\n";
+    std::cout << "   relex:     " << us(relex_time) / edit_count << " us per edit\n";
+    std::cout << "   full lex:  " << us(lex_time) / edit_count << " us per edit  ("
+              << us(lex_time) / us(relex_time) << "x)\n";
+}
@@ -0,0 +1,41 @@
+# This is intended to be run in the /benchmarks directory in a Linux or
+# macOS shell, as
+#
+#   sh run-benchmarks.sh [sizes...]
+#
+# where each size is a number of source lines (the default is 1K to 100K;
+# 1M is opt-in, since translation time grows faster than linearly and
+# the 100K corpus alone takes minutes).
+# It builds cppfront and the corpus generator, then for each size it
+# generates a corpus and translates it with -time-report, which shows
+# each pipeline stage's time, throughput (Klines/s), and peak RSS.
+# Then it runs the lex-scan and relex checks on the first size's corpus,
+# and fails if either finds a difference (see readme.md).
+#
+CXX=${CXX:-g++}
+sizes=${*:-1000 10000 100000}
+
+mkdir -p work
+$CXX -std=c++20 -O2 -o work/cppfront ../source/cppfront.cpp || exit 1
+$CXX -std=c++20 -O2 -o work/generate-corpus generate-corpus.cpp || exit 1
+$CXX -std=c++20 -O2 -o work/lex-scan lex-scan.cpp || exit 1
+$CXX -std=c++20 -O2 -o work/relex relex.cpp || exit 1
+
+summary=""
+for n in $sizes
+do
+    printf "\n==== %s lines ====\n" "$n"
+    ./work/generate-corpus "$n" "work/corpus-$n.cpp2" || exit 1
+    ./work/cppfront -time-report "work/corpus-$n.cpp2" > "work/corpus-$n.output" 2>&1
+    cat "work/corpus-$n.output"
+    summary="$summary$(awk -v n="$n" '/^ *total /{ printf "%10s %12s %12s %10s %8s", n, $2, $3, $4, $5 }' "work/corpus-$n.output")\n"
+done
+
+printf "\n==== Summary ====\n"
+printf "     lines    wall (ms)     cpu (ms)   Klines/s  peak MB\n"
+printf "$summary"
+
+set -- $sizes
+printf "\n==== Checks (%s lines) ====\n" "$1"
+./work/lex-scan 100000 "work/corpus-$1.cpp2" || exit 1
+./work/relex "work/corpus-$1.cpp2" 1000 || exit 1
@@ -0,0 +1,36 @@
+
+
+//=== Cpp2 type declarations ====================================================
+
+
+#include "cpp2util.h"
+
+
+
+//=== Cpp2 type definitions and function declarations ===========================
+
+#include <iostream>
+
+/*
+ *  A Cpp1 block comment
+ */
+
+/*
+ *  A Cpp2 block comment, with *emphasis* and a ** b
+ */
+#line 10 "mixed-multiline-comments.cpp2"
+[[nodiscard]] auto main() -> int;
+    
+
+//=== Cpp2 function definitions =================================================
+
+
+#line 10 "mixed-multiline-comments.cpp2"
+[[nodiscard]] auto main() -> int{
+    auto x {6 * 7}; /* a one-line comment, with * */
+    /*  A block comment that starts after code,
+     *  and ends before code */std::cout << std::move(x) << "\n";
+    /**
+     ** Stars **/
+}
+
@@ -1,17 +1,22 @@
 @echo off
+rem Run as "run-tests.bat parallel" to also pass the hidden flags that make
+rem cppfront load, lex, and parse every test in parallel on 4 threads, lex
+rem while loading, and defer function bodies (see run-tests.sh)
+set flags=
+if "%1"=="parallel" set flags=-_threads 4 -_parallel_load_size 1 -_parallel_lex_sections 1 -_parallel_parse 1 -_fused_lex -_defer_function_bodies
 cppfront.exe -version > version
 del *.cpp *.output
 copy ..\*.cpp2 .
 set count=0
 for %%f in (mixed-*.cpp2) do (
     echo Starting cppfront.exe %%f
-    cppfront.exe %%f > %%f.output 2>&1
+    cppfront.exe %flags% %%f > %%f.output 2>&1
     del %%f
     set /a count+=1
 )
 for %%f in (pure2-*.cpp2) do (
     echo Starting cppfront.exe %%f -p
-    cppfront.exe -p %%f > %%f.output 2>&1
+    cppfront.exe -p %flags% %%f > %%f.output 2>&1
     del %%f
     set /a count+=1
 )
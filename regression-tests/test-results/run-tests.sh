@@ -0,0 +1,41 @@
+# This is intended to be run in the /test-results subdirectory in a Linux
+# or macOS shell, with cppfront built into that directory; it does the same
+# as run-tests.bat
+#
+# Run it as "run-tests.sh parallel" to also pass the hidden flags that make
+# cppfront load, lex, and parse every test in parallel on 4 threads (even on
+# a machine with fewer cores), lex while loading, and defer function bodies;
+# the results should be the same as without them
+#
+flags=
+if test "$1" = "parallel"; then
+    flags="-_threads 4 -_parallel_load_size 1 -_parallel_lex_sections 1 -_parallel_parse 1 -_fused_lex -_defer_function_bodies"
+fi
+./cppfront -version > version
+rm -f *.cpp *.output
+cp ../*.cpp2 .
+count=0
+for f in mixed-*.cpp2
+do
+    printf "Starting cppfront %s\n" "$f"
+    ./cppfront $flags $f > $f.output 2>&1
+    rm -f $f
+    let count=count+1
+done
+for f in pure2-*.cpp2
+do
+    printf "Starting cppfront %s -p\n" "$f"
+    ./cppfront -p $flags $f > $f.output 2>&1
+    rm -f $f
+    let count=count+1
+done
+cpp_count=$(ls *.cpp | wc -l)
+err_count=$(ls ../*error.cpp2 | wc -l)
+total_count=$((cpp_count + err_count))
+printf "\nDone: %s .cpp2 tests compiled\n" "$count"
+printf "\n      %s .cpp files generated\n" "$cpp_count"
+printf "      %s error test cases (should not generate .cpp)\n" "$err_count"
+printf "      %s total\n" "$total_count"
+if test "$total_count" -ne "$count"; then
+    printf "      *** MISMATCH: should equal total tests run\n"
+fi
@@ -28,6 +28,7 @@
 #include <string>
 #include <string_view>
 #include <vector>
+#include <bit>
 #include <cstdint>
 #include <cctype>
 #include <cassert>
@@ -35,6 +36,15 @@
 #include <compare>
 #include <algorithm>
 #include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+//  SSE2 is used, where available, to scan source text 16 bytes at a time
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define CPP2_USE_SSE2
+    #include <emmintrin.h>
+#endif
 
 namespace cpp2 {
 
@@ -46,7 +56,7 @@ namespace cpp2 {
 //
 struct source_line
 {
-    std::string text;
+    std::string_view text;  // a view of the loaded file, or of generated text
 
     enum class category { empty, preprocessor, comment, import, cpp1, cpp2, rawstring };
     category cat;
@@ -113,11 +123,11 @@ struct comment
     enum class comment_kind { line_comment = 0, stream_comment };
 
     comment_kind    kind;
-    source_position start;
-    source_position end;
-    std::string     text;
+    source_position  start;
+    source_position  end;
+    std::string_view text;      // a view of the source, or of generated_text if it spans lines
 
-    mutable bool    dbg_was_printed = false;
+    mutable bool     dbg_was_printed = false;
 };
 
 struct string_parts {
@@ -236,12 +246,14 @@ struct raw_string
     std::string     opening_seq;
     std::string     closing_seq;
     bool            should_interpolate = false;
+
+    auto operator==(raw_string const&) const -> bool = default;
 };
 
 struct multiline_raw_string
 {
-    std::string     text;
-    source_position end = {0, 0};
+    std::string_view text;      // stored in the lexer's generated_text
+    source_position  end = {0, 0};
 };
 
 //-----------------------------------------------------------------------
@@ -358,6 +370,205 @@ auto is_identifier_continue(char c)
         ;
 }
 
+//  Helper to allow one of the above or a digit separator
+//  Example:    is_separator_or( is_binary_digit (c) )
+//
+auto is_separator_or(auto pred, char c)
+    -> bool
+{
+    return
+        c == '\''
+        || pred(c)
+        ;
+}
+
+
+//-----------------------------------------------------------------------
+//
+//  Scanning runs of characters, for the lexer
+//
+//  Each skip_* returns the first position at or after pos in s whose
+//  character is not in the run. With SSE2 (every x64 target) they first
+//  check 16 characters at a time, using only an ASCII subset of the
+//  character class that is cheap to test a block at a time, and then
+//  finish one character at a time with the predicates above, which stay
+//  the definition of each class (so the block test only ever has to be
+//  sure, not complete)
+//
+//-----------------------------------------------------------------------
+//
+#ifdef CPP2_USE_SSE2
+
+using char_block = __m128i;
+
+auto load_block(char const* p)
+    -> char_block
+{
+    return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+}
+
+//  A bit per lane that is set (all ones)
+auto block_mask(char_block x)
+    -> unsigned
+{
+    return unsigned(_mm_movemask_epi8(x));
+}
+
+//  Lanes that are in [lo,hi], for lo and hi in 0x01..0x7e
+auto block_in_range(char_block x, char lo, char hi)
+    -> char_block
+{
+    return _mm_and_si128(
+        _mm_cmpgt_epi8(x, _mm_set1_epi8(char(lo-1))),
+        _mm_cmplt_epi8(x, _mm_set1_epi8(char(hi+1)))
+    );
+}
+
+auto block_is(char_block x, char c)
+    -> char_block
+{
+    return _mm_cmpeq_epi8(x, _mm_set1_epi8(c));
+}
+
+//  Maps ASCII letters to lower case (and other characters elsewhere)
+auto block_to_lower(char_block x)
+    -> char_block
+{
+    return _mm_or_si128(x, _mm_set1_epi8(0x20));
+}
+
+auto block_or(char_block x, char_block y)
+    -> char_block
+{
+    return _mm_or_si128(x, y);
+}
+
+auto block_not(char_block x)
+    -> char_block
+{
+    return _mm_xor_si128(x, _mm_set1_epi8(-1));
+}
+
+#else
+
+//  Without SSE2 there are no blocks, and skip_run never uses these
+struct char_block { };
+auto block_in_range(char_block, char, char) -> char_block { return {}; }
+auto block_is      (char_block, char)       -> char_block { return {}; }
+auto block_to_lower(char_block)             -> char_block { return {}; }
+auto block_or      (char_block, char_block) -> char_block { return {}; }
+auto block_not     (char_block)             -> char_block { return {}; }
+
+#endif
+
+auto skip_run(
+    std::string_view s,
+    int              pos,
+    auto             in_block,
+    auto             in_run
+)
+    -> int
+{
+    auto const size = std::ssize(s);
+#ifdef CPP2_USE_SSE2
+    //  Most runs are short, so check the next few characters one at a time
+    //  before setting up to check blocks
+    for (auto n = 0; n < 4; ++n, ++pos) {
+        if (pos >= size || !in_run(s[pos])) {
+            return pos;
+        }
+    }
+    for ( ; pos + 16 <= size; pos += 16) {
+        if (auto mask = block_mask(in_block(load_block(s.data() + pos))); mask != 0xffff) {
+            pos += std::countr_one(mask);
+            break;
+        }
+    }
+#else
+    (void)in_block;
+#endif
+    while (pos < size && in_run(s[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+//  Identifier characters
+auto skip_identifier_continue(std::string_view s, int pos)
+    -> int
+{
+    return skip_run(
+        s, pos,
+        [](char_block x) {
+            return block_or(
+                block_or(block_in_range(block_to_lower(x), 'a', 'z'), block_in_range(x, '0', '9')),
+                block_is(x, '_')
+            );
+        },
+        is_identifier_continue
+    );
+}
+
+//  Whitespace
+auto skip_whitespace(std::string_view s, int pos)
+    -> int
+{
+    return skip_run(
+        s, pos,
+        [](char_block x) {
+            return block_or(block_is(x, ' '), block_in_range(x, '\t', '\r'));
+        },
+        [](char c) { return isspace(c) != 0; }
+    );
+}
+
+//  Digits and digit separators
+auto skip_digits(std::string_view s, int pos)
+    -> int
+{
+    return skip_run(
+        s, pos,
+        [](char_block x) {
+            return block_or(block_in_range(x, '0', '9'), block_is(x, '\''));
+        },
+        [](char c) { return is_separator_or(is_digit, c); }
+    );
+}
+
+//  Hexadecimal digits and digit separators
+auto skip_hexadecimal_digits(std::string_view s, int pos)
+    -> int
+{
+    return skip_run(
+        s, pos,
+        [](char_block x) {
+            return block_or(
+                block_or(block_in_range(x, '0', '9'), block_in_range(block_to_lower(x), 'a', 'f')),
+                block_is(x, '\'')
+            );
+        },
+        [](char c) { return is_separator_or(is_hexadecimal_digit, c); }
+    );
+}
+
+//  The characters of a string literal that stand for themselves (not
+//  the closing quote, or a \ that starts an escape sequence)
+auto skip_plain_string_chars(std::string_view s, int pos)
+    -> int
+{
+    return skip_run(
+        s, pos,
+        [](char_block x) {
+            return block_not(block_or(
+                block_or(block_is(x, '"'), block_is(x, '\\')),
+                block_is(x, '\0')
+            ));
+        },
+        [](char c) { return c != '"' && c != '\\' && c != '\0'; }
+    );
+}
+
+
 //G identifier:
 //G     identifier-start
 //G     identifier identifier-continue
@@ -367,33 +578,12 @@ auto starts_with_identifier(std::string_view s)
     -> int
 {
     if (is_identifier_start(s[0])) {
-        auto j = 1;
-        while (
-            j < std::ssize(s)
-            && is_identifier_continue(s[j])
-            )
-        {
-            ++j;
-        }
-        return j;
+        return skip_identifier_continue(s, 1);
     }
     return 0;
 };
 
 
-//  Helper to allow one of the above or a digit separator
-//  Example:    is_separator_or( is_binary_digit (c) )
-//
-auto is_separator_or(auto pred, char c)
-    -> bool
-{
-    return
-        c == '\''
-        || pred(c)
-        ;
-}
-
-
 //  Bool to string
 //
 template<typename T>
@@ -511,6 +701,117 @@ auto contains(
 }
 
 
+//-----------------------------------------------------------------------
+//
+//  Tracing: timed spans of compiler work, for -trace
+//
+//  The spans are recorded here, and written out as Chrome trace events
+//  by the driver. When tracing is off, a trace_span does nothing.
+//
+//-----------------------------------------------------------------------
+//
+class tracer
+{
+public:
+    struct event {
+        std::string   category;
+        std::string   name;
+        double        start_us    = 0;
+        double        duration_us = 0;
+        int           thread      = 0;
+    };
+
+private:
+    std::atomic<bool>                     on     = false;
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    std::mutex                            events_mutex;
+    std::vector<event>                    recorded;
+    std::atomic<int>                      next_thread = 0;
+
+public:
+    auto enable(bool b = true)
+        -> void
+    {
+        on = b;
+    }
+
+    auto enabled() const
+        -> bool
+    {
+        return on;
+    }
+
+    auto now_us() const
+        -> double
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    //  A small stable number for the calling thread
+    auto thread_number()
+        -> int
+    {
+        thread_local auto number = next_thread++;
+        return number;
+    }
+
+    auto record(event e)
+        -> void
+    {
+        auto lock = std::lock_guard{events_mutex};
+        recorded.push_back(std::move(e));
+    }
+
+    //  Take the events recorded so far, leaving none
+    auto take_events()
+        -> std::vector<event>
+    {
+        auto lock = std::lock_guard{events_mutex};
+        return std::exchange(recorded, {});
+    }
+};
+
+static tracer tracing;
+
+
+class trace_span
+{
+    bool         active = false;
+    tracer::event e;
+
+public:
+    trace_span(
+        std::string_view category,
+        std::string_view name,
+        std::string_view detail = {}
+    )
+        : active{tracing.enabled()}
+    {
+        if (active) {
+            e.category = category;
+            e.name     = name;
+            if (!detail.empty()) {
+                e.name += " ";
+                e.name += detail;
+            }
+            e.thread   = tracing.thread_number();
+            e.start_us = tracing.now_us();
+        }
+    }
+
+    ~trace_span()
+    {
+        if (active) {
+            e.duration_us = tracing.now_us() - e.start_us;
+            tracing.record(std::move(e));
+        }
+    }
+
+    trace_span(trace_span const&)            = delete;
+    trace_span& operator=(trace_span const&) = delete;
+};
+
+
 //-----------------------------------------------------------------------
 //
 //  Command line handling
@@ -527,7 +828,7 @@ class cmdline_processor
         int pos;
         std::string text;
 
-        arg(int p, char* t) : pos{p}, text{t} { }
+        arg(int p, std::string_view t) : pos{p}, text{t} { }
     };
     std::vector<arg> args;
 
@@ -551,6 +852,9 @@ class cmdline_processor
     std::vector<flag> flags;
     int max_flag_length = 0;
 
+    //  The flags that were actually used, in canonical form (e.g., "output=x.cpp")
+    std::vector<std::string> used_flags;
+
     std::unordered_map<int, std::string> labels = {
         { 2, "Additional dynamic safety checks and contract information" },
         { 4, "Support for constrained target environments" },
@@ -623,9 +927,12 @@ public:
                 {
                     assert(flag.handler0 || flag.handler1);
 
+                    auto canonical_name = flag.name.substr(0, flag.name.find(' '));
+
                     //  If this is a standalone switch, just process it
                     if (flag.handler0) {
                         flag.handler0();
+                        used_flags.push_back(canonical_name);
                     }
 
                     //  Else
@@ -633,6 +940,7 @@ public:
                         //  If this is a switch that could be suffixed with "-" to opt out
                         if (flag.opt_out) {
                             flag.handler1( arg->text.ends_with("-") ? "-" : "" );
+                            used_flags.push_back(canonical_name + (arg->text.ends_with("-") ? "-" : ""));
                         }
                         //  Else this is a switch that takes the next arg as its value, so pass that
                         else {
@@ -643,6 +951,7 @@ public:
                             arg->pos = processed;
                             ++arg;  // move to next argument, which is the argument to this switch
                             flag.handler1(arg->text);
+                            used_flags.push_back(canonical_name + "=" + arg->text);
                         }
                     }
 
@@ -743,6 +1052,17 @@ public:
         }
     }
 
+    //  Start over with a new command line (e.g., for a compile server request)
+    auto set_args(std::vector<std::string> const& new_args)
+        -> void
+    {
+        help_requested = false;
+        args.clear();
+        for (auto i = 0; auto const& a : new_args) {
+            args.emplace_back( ++i, a );
+        }
+    }
+
     auto help_was_requested()
         -> bool
     {
@@ -755,6 +1075,26 @@ public:
         return args;
     }
 
+    auto flags_used() const
+        -> std::vector<std::string> const&
+    {
+        return used_flags;
+    }
+
+    auto set_flags_used(std::vector<std::string> const& flags)
+        -> void
+    {
+        used_flags = flags;
+    }
+
+    auto version() const
+        -> std::string_view
+    {
+        return "cppfront compiler v0.2.1   Build "
+            #include "build.info"
+        ;
+    }
+
     //  This is used only by the owner of the 'main' branch
     //  to generate stable build version strings
     auto gen_version()
@@ -779,9 +1119,8 @@ public:
         -> void
     {
         help_requested = true;
-        print("\ncppfront compiler v0.2.1   Build "
-            #include "build.info"
-        );
+        print("\n");
+        print(version());
         print("\nCopyright(c) Herb Sutter   All rights reserved\n");
         print("\nSPDX-License-Identifier: CC-BY-NC-ND-4.0");
         print("\n  No commercial use");
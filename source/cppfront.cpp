@@ -19,18 +19,38 @@
 #include <iostream>
 #include <cstdio>
 #include <optional>
+#include <sstream>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <array>
+#include <filesystem>
+#include <csignal>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 namespace cpp2 {
 
+//  Where cmdline_processor prints help and version information
+//  (the compile server redirects this into each request's output)
+static auto cmdline_out = static_cast<std::ostream*>(&std::cout);
+
 //  Defined out of line here just to avoid bringing <iostream> into the headers,
 //  so that we can't accidentally start depending on iostreams in the compiler body
 auto cmdline_processor::print(std::string_view s, int width)
     -> void
 {
     if (width > 0) {
-        std::cout << std::setw(width) << std::left;
+        *cmdline_out << std::setw(width) << std::left;
     }
-    std::cout << s;
+    *cmdline_out << s;
 }
 
 
@@ -151,6 +171,63 @@ static cmdline_processor::register_flag cmd_no_rtti(
     []{ flag_no_rtti = true; }
 );
 
+static auto flag_parallel_load_size = source::default_parallel_min_size;
+static cmdline_processor::register_flag cmd_parallel_load_size(
+    9,
+    "_parallel_load_size bytes",
+    "Classify source files at least this big in parallel chunks",
+    nullptr,
+    [](std::string const& bytes) { flag_parallel_load_size = std::strtoull(bytes.c_str(), nullptr, 10); }
+);
+
+static auto flag_fused_lex = false;
+static cmdline_processor::register_flag cmd_fused_lex(
+    9,
+    "_fused_lex",
+    "Lex Cpp2 code while loading, and use its tokens to find definitions",
+    []{ flag_fused_lex = true; }
+);
+
+static auto flag_parallel_lex_sections = tokens::default_parallel_min_sections;
+static cmdline_processor::register_flag cmd_parallel_lex_sections(
+    9,
+    "_parallel_lex_sections N",
+    "Lex source files with at least N Cpp2 sections in parallel",
+    nullptr,
+    [](std::string const& n) { flag_parallel_lex_sections = std::max(1, atoi(n.c_str())); }
+);
+
+static auto flag_defer_function_bodies = false;
+static cmdline_processor::register_flag cmd_defer_function_bodies(
+    9,
+    "_defer_function_bodies",
+    "Parse function bodies after all the declarations",
+    []{ flag_defer_function_bodies = true; }
+);
+
+static auto flag_parallel_parse = cpp2::parser::default_parallel_min_sections;
+static cmdline_processor::register_flag cmd_parallel_parse(
+    9,
+    "_parallel_parse N",
+    "Parse source files with at least N Cpp2 sections (or deferred function bodies) in parallel",
+    nullptr,
+    [](std::string const& n) { flag_parallel_parse = std::max(1, atoi(n.c_str())); }
+);
+
+static cmdline_processor::register_flag cmd_threads(
+    9,
+    "_threads N",
+    "Use N threads for parallel loading, lexing, and parsing (default: the hardware's)",
+    nullptr,
+    [](std::string const& n) { parallel_threads_override = std::max(1, atoi(n.c_str())); }
+);
+
+//  Whether source files may be memory-mapped (see source), which a compile
+//  server turns off (see serve): a mapped file that another process
+//  truncates or rewrites while it's being translated makes reading its
+//  lines fault, and that mustn't take down a long-running server
+static auto map_source_files = true;
+
 struct text_with_pos{
     std::string     text;
     source_position pos;
@@ -194,6 +271,7 @@ class positional_printer
     std::ostream*               out             = {}; // will point to out_file or cout
     std::string                 cpp2_filename   = {};
     std::string                 cpp1_filename   = {};
+    bool                        reopened        = false; // also wrote cpp1_filename + "pp"
     std::vector<comment> const* pcomments       = {}; // Cpp2 comments data
     source const*               psource         = {};
     parser const*               pparser         = {};
@@ -635,6 +713,20 @@ public:
         assert(cpp1_filename.ends_with(".h"));
         out_file.close();
         out_file.open(cpp1_filename + "pp");
+        reopened = true;
+    }
+
+    auto output_filenames() const
+        -> std::vector<std::string>
+    {
+        auto ret = std::vector<std::string>{};
+        if (out && cpp1_filename != "stdout") {
+            ret.push_back(cpp1_filename);
+            if (reopened) {
+                ret.push_back(cpp1_filename + "pp");
+            }
+        }
+        return ret;
     }
 
     auto is_open()
@@ -711,6 +803,43 @@ public:
     }
 
 
+    //-----------------------------------------------------------------------
+    //  Print a whole file that has no Cpp2 and so passes through unchanged
+    //
+    //  The output is the same as from calling print_cpp1 for each line, but
+    //  is produced by a bulk copy of the source file where possible, else
+    //  by one large write
+    //
+    auto print_cpp1_file( std::string_view contents )
+        -> void
+    {
+        assert(
+            is_open()
+            && curr_pos == source_position{}
+            && "ICE: printer must be open and nothing printed yet"
+        );
+
+        auto copied = false;
+        if (out == &out_file) {
+            out_file.close();
+            copied = copy_whole_file(cpp2_filename, cpp1_filename, contents.size());
+            out_file.open(cpp1_filename, copied ? std::ios::app : std::ios::trunc);
+        }
+        if (!copied) {
+            out->write(contents.data(), std::ssize(contents));
+        }
+
+        //  print_cpp1 ends every line with a newline, including the last
+        if (
+            !contents.empty()
+            && contents.back() != '\n'
+            )
+        {
+            *out << '\n';
+        }
+    }
+
+
     //-----------------------------------------------------------------------
     //  Used when we start a new Cpp2 section, or when we emit the same item
     //  more than once (notably when we emit operator= more than once)
@@ -975,6 +1104,221 @@ public:
 };
 
 
+//-----------------------------------------------------------------------
+//
+//  time_report: how long each translation step took, for -time-report
+//
+//-----------------------------------------------------------------------
+//
+static auto flag_time_report = false;
+static cmdline_processor::register_flag cmd_time_report(
+    9,
+    "time-report",
+    "Print the time taken by each translation step, per file and in total",
+    []{ flag_time_report = true; }
+);
+
+//  The number of slowest top-level declarations to list
+constexpr auto time_report_slowest_count = 10;
+
+struct step_time {
+    std::chrono::nanoseconds wall     = {};
+    std::chrono::nanoseconds cpu      = {};
+    std::size_t              peak_rss = 0;  // process high-water mark at the end of the step, in bytes
+
+    auto operator+=(step_time const& that)
+        -> step_time&
+    {
+        wall    += that.wall;
+        cpu     += that.cpu;
+        peak_rss = std::max(peak_rss, that.peak_rss);
+        return *this;
+    }
+};
+
+//  Peak resident set size of the whole process so far, in bytes, or 0 if
+//  not available on this platform
+auto peak_rss()
+    -> std::size_t
+{
+#ifndef _WIN32
+    auto usage = rusage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return std::size_t(usage.ru_maxrss);            // bytes
+#else
+    return std::size_t(usage.ru_maxrss) * 1024;     // kilobytes
+#endif
+#else
+    return 0;
+#endif
+}
+
+//  CPU time used by the calling thread, which is the thread doing the
+//  translation even when several files are being translated at once
+auto thread_cpu_time()
+    -> std::chrono::nanoseconds
+{
+#ifndef _WIN32
+    auto ts = timespec{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds{ts.tv_sec} + std::chrono::nanoseconds{ts.tv_nsec};
+#else
+    //  Fall back to process CPU time
+    return std::chrono::nanoseconds{ std::clock() * (1'000'000'000 / CLOCKS_PER_SEC) };
+#endif
+}
+
+struct time_report
+{
+    enum step : int {
+        load, lex, parse, sema, local_rules,
+        lower_type_decls, lower_type_defs_func_decls, lower_func_defs,
+        step_count
+    };
+    static constexpr std::string_view step_names[step_count] = {
+        "load", "lex", "parse", "sema", "local rules",
+        "lower: type declarations", "lower: type defs/func decls", "lower: func definitions"
+    };
+
+    struct declaration_time {
+        std::string              name;
+        std::string              filename;
+        source_position          pos;
+        std::chrono::nanoseconds wall = {};
+    };
+
+    int                           files = 0;
+    lineno_t                      lines = 0;  // source lines, for throughput
+    std::array<step_time, step_count> steps;
+    std::vector<declaration_time> slowest;    // sorted, slowest first
+
+    //  Keep only the slowest declarations
+    auto add_declarations(std::vector<declaration_time> decls)
+        -> void
+    {
+        slowest.insert( slowest.end(), std::make_move_iterator(decls.begin()), std::make_move_iterator(decls.end()) );
+        std::stable_sort(
+            slowest.begin(),
+            slowest.end(),
+            [](auto const& a, auto const& b) { return a.wall > b.wall; }
+        );
+        if (std::ssize(slowest) > time_report_slowest_count) {
+            slowest.resize(time_report_slowest_count);
+        }
+    }
+
+    auto operator+=(time_report const& that)
+        -> time_report&
+    {
+        files += that.files;
+        lines += that.lines;
+        for (auto i = 0; i < step_count; ++i) {
+            steps[i] += that.steps[i];
+        }
+        add_declarations(that.slowest);
+        return *this;
+    }
+
+    auto print(std::ostream& o) const
+        -> void
+    {
+        auto ms = [](std::chrono::nanoseconds t) {
+            auto ss = std::ostringstream{};
+            ss << std::fixed << std::setprecision(3) << std::setw(12) << __as<double>(t.count()) / 1'000'000;
+            return ss.str();
+        };
+
+        //  Throughput in thousands of source lines per second of wall time
+        auto klines_per_sec = [&](std::chrono::nanoseconds t) {
+            auto ss = std::ostringstream{};
+            ss << std::setw(11);
+            if (t.count() > 0) {
+                ss << std::fixed << std::setprecision(0) << __as<double>(lines) * 1'000'000 / __as<double>(t.count());
+            }
+            else {
+                ss << "-";
+            }
+            return ss.str();
+        };
+
+        auto mb = [](std::size_t bytes) {
+            auto ss = std::ostringstream{};
+            ss << std::fixed << std::setprecision(1) << std::setw(9) << __as<double>(bytes) / (1024 * 1024);
+            return ss.str();
+        };
+
+        o << "   " << std::setw(30) << std::left << "Time (ms)" << std::right << "        wall         cpu   Klines/s  peak MB\n";
+        auto total = step_time{};
+        for (auto i = 0; i < step_count; ++i) {
+            o << "     " << std::setw(28) << std::left << step_names[i] << std::right
+              << ms(steps[i].wall) << ms(steps[i].cpu) << klines_per_sec(steps[i].wall) << mb(steps[i].peak_rss) << "\n";
+            total += steps[i];
+        }
+        o << "     " << std::setw(28) << std::left << "total" << std::right
+          << ms(total.wall) << ms(total.cpu) << klines_per_sec(total.wall) << mb(total.peak_rss) << "\n";
+
+        if (!slowest.empty()) {
+            o << "   Slowest declarations to lower (ms)\n";
+            for (auto const& decl : slowest) {
+                o << "     " << ms(decl.wall) << "  " << decl.name
+                  << " (" << decl.filename << "(" << decl.pos.lineno << "," << decl.pos.colno << "))\n";
+            }
+        }
+    }
+};
+
+//  Times a sequence of steps: each begin() ends the previous step, and
+//  the last step ends when the timer is destroyed. Does nothing unless
+//  -time-report or -trace is on.
+class step_timer
+{
+    time_report&                          report;
+    int                                   current = -1;
+    std::chrono::steady_clock::time_point wall_start;
+    std::chrono::nanoseconds              cpu_start;
+    std::optional<trace_span>             span;
+
+public:
+    step_timer(time_report& r)
+        : report{r}
+    { }
+
+    auto begin(time_report::step s)
+        -> void
+    {
+        end();
+        if (tracing.enabled()) {
+            span.emplace( "stage", time_report::step_names[s] );
+        }
+        if (flag_time_report) {
+            current    = s;
+            wall_start = std::chrono::steady_clock::now();
+            cpu_start  = thread_cpu_time();
+        }
+    }
+
+    auto end()
+        -> void
+    {
+        span.reset();
+        if (current >= 0) {
+            report.steps[current].wall += std::chrono::steady_clock::now() - wall_start;
+            report.steps[current].cpu  += thread_cpu_time() - cpu_start;
+            report.steps[current].peak_rss = std::max(report.steps[current].peak_rss, peak_rss());
+            current = -1;
+        }
+    }
+
+    ~step_timer()
+    {
+        end();
+    }
+};
+
+
 //-----------------------------------------------------------------------
 //
 //  cppfront: a compiler instance
@@ -998,8 +1342,12 @@ class cppfront
     cpp2::parser parser;
     cpp2::sema   sema;
 
+    time_report                                                  timings;
+    std::unordered_map<declaration_node const*, std::chrono::nanoseconds> declaration_timings;
+
     bool source_loaded                  = true;
     bool last_postfix_expr_was_pointer  = false;
+    bool violates_lifetime_safety       = false;
     bool violates_bounds_safety         = false;
     bool violates_initialization_safety = false;
     bool suppress_move_from_last_use    = false;
@@ -1103,6 +1451,36 @@ class cppfront
     auto consumed_expression_list_parens()          -> void { if( std::ssize(need_expression_list_parens) > 1 )
                                                                   need_expression_list_parens.back() = false;      }
 
+    //-----------------------------------------------------------------------
+    //  cpp1_filename_for: The file that lowering 'filename' writes
+    //
+    static auto cpp1_filename_for(std::string const& filename)
+        -> std::string
+    {
+        if (!flag_cpp1_filename.empty()) {
+            return flag_cpp1_filename; // use override if present
+        }
+        return filename.substr(0, std::ssize(filename) - 1);
+    }
+
+    //-----------------------------------------------------------------------
+    //  overwrites_source: Whether lowering 'filename' writes over it (e.g.,
+    //  with -o naming the source file), including via the .hpp that a
+    //  .h2's .h is followed by
+    //
+    static auto overwrites_source(std::string const& filename)
+        -> bool
+    {
+        auto cpp1_filename = cpp1_filename_for(filename);
+        auto ec            = std::error_code{};
+        return
+            cpp1_filename != "stdout"
+            && (
+                std::filesystem::equivalent(filename, cpp1_filename, ec)
+                || std::filesystem::equivalent(filename, cpp1_filename + "pp", ec)
+                );
+    }
+
 public:
     //-----------------------------------------------------------------------
     //  Constructor
@@ -1111,11 +1489,16 @@ public:
     //
     cppfront(std::string const& filename)
         : sourcefile{ filename }
-        , source    { errors }
+        , source    { errors, map_source_files && !overwrites_source(filename) }
         , tokens    { errors }
         , parser    { errors }
         , sema      { errors }
     {
+        auto timer = step_timer{timings};
+        timer.begin(time_report::load);
+        timings.files = 1;
+        auto fused_lexer = tokens.fused();
+
         //  "Constraints enable creativity in the right directions"
         //  sort of applies here
         //
@@ -1130,9 +1513,15 @@ public:
             );
         }
 
-        //  Load the program file into memory
+        //  Load the program file into memory, and with -_fused_lex also
+        //  tokenize the Cpp2 code as it's found
         //
-        else if (!source.load(sourcefile))
+        else if (
+            !(flag_fused_lex
+                ? source.load(sourcefile, flag_parallel_load_size, fused_lexer)
+                : source.load(sourcefile, flag_parallel_load_size)
+                )
+            )
         {
             if (errors.empty()) {
                 errors.emplace_back(
@@ -1145,27 +1534,54 @@ public:
 
         else
         {
+            timings.lines = std::ssize(source.get_lines()) - 1;     // less the dummy first line
+
             //  Tokenize
             //
-            tokens.lex(source.get_lines());
+            timer.begin(time_report::lex);
+            if (flag_fused_lex) {
+                fused_lexer.finish();
+            }
+            else {
+                tokens.lex(source.get_lines(), false, flag_parallel_lex_sections);
+            }
 
             //  Parse
             //
             try
             {
-                for (auto const& [line, entry] : tokens.get_map()) {
-                    if (!parser.parse(entry, tokens.get_generated())) {
+                timer.begin(time_report::parse);
+                auto const& sections = tokens.get_sections();
+                auto section_tokens = std::vector<std::span<token const>>{};
+                for (auto const& section : sections) {
+                    section_tokens.push_back( tokens.get_tokens(section) );
+                }
+                auto section_parsed = [&](int i, bool ok) {
+                    if (!ok) {
                         errors.emplace_back(
-                            source_position(line, 0),
+                            source_position(sections[i].lineno, 0),
                             "parse failed for section starting here",
                             false,
                             true    // a noisy fallback error message
                         );
                     }
+                };
+                parser.parse_sections(
+                    section_tokens,
+                    tokens.get_generated(),
+                    flag_defer_function_bodies,
+                    flag_parallel_parse,
+                    section_parsed
+                );
+                if (flag_defer_function_bodies) {
+                    auto span = trace_span{ "section", "parse deferred function bodies" };
+                    parser.parse_deferred_function_bodies(flag_parallel_parse, section_parsed);
                 }
 
                 //  Sema
+                timer.begin(time_report::sema);
                 parser.visit(sema);
+                timer.begin(time_report::local_rules);
                 if (!sema.apply_local_rules()) {
                     violates_initialization_safety = true;
                 }
@@ -1185,6 +1601,22 @@ public:
     //
     //  Emits the target file with the last '2' stripped
     //
+    //-----------------------------------------------------------------------
+    //  emit_top_level: Emit a top-level declaration (in any phase),
+    //  recording how long it took if we're reporting times
+    //
+    auto emit_top_level(declaration_node const& decl)
+        -> void
+    {
+        if (!flag_time_report) {
+            emit(decl);
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        emit(decl);
+        declaration_timings[&decl] += std::chrono::steady_clock::now() - start;
+    }
+
     struct lower_to_cpp1_ret {
         lineno_t cpp1_lines = 0;
         lineno_t cpp2_lines = 0;
@@ -1200,10 +1632,7 @@ public:
         }
 
         //  Now we'll open the Cpp1 file
-        auto cpp1_filename = sourcefile.substr(0, std::ssize(sourcefile) - 1);
-        if (!flag_cpp1_filename.empty()) {
-            cpp1_filename = flag_cpp1_filename; // use override if present
-        }
+        auto cpp1_filename = cpp1_filename_for(sourcefile);
 
         printer.open(
             sourcefile,
@@ -1224,6 +1653,29 @@ public:
         auto cpp1_FILENAME = to_upper_and_underbar(cpp1_filename);
 
 
+        //---------------------------------------------------------------------
+        //  A file with no Cpp2 passes through unchanged, so copy it in bulk
+        //  unless a line needs rewriting (a .h2 #include) or checking (under
+        //  -pure-cpp2), in which case it takes the normal path below
+        //
+        if (
+            !source.has_cpp2()
+            && !flag_cpp2_only
+            && std::ranges::none_of(source.get_lines(), [](auto const& line) {
+                return line.cat == source_line::category::preprocessor
+                    && line.text.ends_with(".h2\"");
+            })
+            )
+        {
+            auto timer = step_timer{timings};
+            timer.begin(time_report::lower_type_defs_func_decls);
+
+            printer.print_cpp1_file( source.get_text() );
+            ret.cpp1_lines = std::ssize(source.get_lines()) - 1;    // less the dummy first line
+            return ret;
+        }
+
+
         //---------------------------------------------------------------------
         //  Do lowered file prolog
         // 
@@ -1251,7 +1703,7 @@ public:
             }
         }
 
-        auto map_iter = tokens.get_map().cbegin();
+        auto section_iter = tokens.get_sections().cbegin();
         auto hpp_includes = std::string{};
 
 
@@ -1259,6 +1711,9 @@ public:
         //  Do phase0_type_decls
         assert(printer.get_phase() == printer.phase0_type_decls);
 
+        auto timer = step_timer{timings};
+        timer.begin(time_report::lower_type_decls);
+
         if (
             source.has_cpp2()
             && !flag_clean_cpp1
@@ -1267,20 +1722,21 @@ public:
             printer.print_extra( "\n//=== Cpp2 type declarations ====================================================\n\n" );
         }
 
-        if (!tokens.get_map().empty())
+        if (!tokens.get_sections().empty())
         {
             printer.print_extra( "\n#include \"cpp2util.h\"\n\n" );
         }
 
-        for (auto& section : tokens.get_map())
+        for (auto const& section : tokens.get_sections())
         {
-            assert (!section.second.empty());
+            assert (section.first < section.last);
+            auto span = trace_span{ "section", "lower section", "at line " + std::to_string(section.lineno) };
 
             //  Get the parse tree for this section and emit each forward declaration
-            auto decls = parser.get_parse_tree_declarations_in_range(section.second);
+            auto decls = parser.get_parse_tree_declarations_in_range(tokens.get_tokens(section));
             for (auto& decl : decls) {
                 assert(decl);
-                emit(*decl);
+                emit_top_level(*decl);
             }
         }
 
@@ -1290,6 +1746,7 @@ public:
         //
         printer.finalize_phase();
         printer.next_phase();
+        timer.begin(time_report::lower_type_defs_func_decls);
 
         if (
             source.has_cpp2()
@@ -1354,7 +1811,7 @@ public:
                         )
                     {
                         //  Strip off the 2"
-                        auto h_include = line.text.substr(0, line.text.size()-2);
+                        auto h_include = std::string{line.text.substr(0, line.text.size()-2)};
                         printer.print_cpp1( h_include + "\"", curr_lineno );
                         hpp_includes += h_include + "pp\"\n";
                     }
@@ -1369,21 +1826,22 @@ public:
 
                     //  We should be in a position to emit a set of Cpp2 declarations
                     if (
-                        map_iter != tokens.get_map().cend()
-                        && map_iter->first /*line*/ <= curr_lineno
+                        section_iter != tokens.get_sections().cend()
+                        && section_iter->lineno <= curr_lineno
                         )
                     {
                         //  We should be here only when we're at exactly the first line of a Cpp2 section
-                        assert (map_iter->first == curr_lineno);
-                        assert (!map_iter->second.empty());
+                        assert (section_iter->lineno == curr_lineno);
+                        assert (section_iter->first < section_iter->last);
+                        auto span = trace_span{ "section", "lower section", "at line " + std::to_string(curr_lineno) };
 
                         //  Get the parse tree for this section and emit each forward declaration
-                        auto decls = parser.get_parse_tree_declarations_in_range(map_iter->second);
+                        auto decls = parser.get_parse_tree_declarations_in_range(tokens.get_tokens(*section_iter));
                         for (auto& decl : decls) {
                             assert(decl);
-                            emit(*decl);
+                            emit_top_level(*decl);
                         }
-                        ++map_iter;
+                        ++section_iter;
                     }
                 }
             }
@@ -1437,20 +1895,22 @@ public:
         //
         printer.finalize_phase();
         printer.next_phase();
+        timer.begin(time_report::lower_func_defs);
 
         if (!flag_clean_cpp1) {
             printer.print_extra( "\n//=== Cpp2 function definitions =================================================\n\n" );
         }
 
-        for (auto& section : tokens.get_map())
+        for (auto const& section : tokens.get_sections())
         {
-            assert (!section.second.empty());
+            assert (section.first < section.last);
+            auto span = trace_span{ "section", "lower section", "at line " + std::to_string(section.lineno) };
 
             //  Get the parse tree for this section and emit each forward declaration
-            auto decls = parser.get_parse_tree_declarations_in_range(section.second);
+            auto decls = parser.get_parse_tree_declarations_in_range(tokens.get_tokens(section));
             for (auto& decl : decls) {
                 assert(decl);
-                emit(*decl);
+                emit_top_level(*decl);
             }
         }
 
@@ -1584,7 +2044,7 @@ public:
             printer.print_cpp2(n, pos, true);
         }
 
-        in_definite_init = is_definite_initialization(&n);
+        in_definite_init = sema.is_definite_initialization(&n);
     }
 
 
@@ -1618,7 +2078,7 @@ public:
     )
         -> void
     {
-        auto last_use = is_definite_last_use(n.identifier);
+        auto last_use = sema.is_definite_last_use(n.identifier);
 
         bool add_forward =
             last_use
@@ -1680,7 +2140,7 @@ public:
             printer.print_cpp2(">", n.close_angle);
         }
 
-        in_definite_init = is_definite_initialization(n.identifier);
+        in_definite_init = sema.is_definite_initialization(n.identifier);
         if (
             !in_definite_init
             && !in_parameter_list
@@ -3226,11 +3686,22 @@ public:
 
     //-----------------------------------------------------------------------
     //
-    template<
-        String   Name,
-        typename Term
-    >
-    auto emit(binary_expression_node<Name,Term> const& n)
+    auto emit(binary_operand const& n)
+        -> void
+    {
+        assert(n);
+        if (n.binary) {
+            emit(*n.binary);
+        }
+        else {
+            emit(*n.leaf);
+        }
+    }
+
+
+    //-----------------------------------------------------------------------
+    //
+    auto emit(binary_expression_node const& n)
         -> void
     {
         assert(n.expr);
@@ -3275,7 +3746,7 @@ public:
                     }
                 }
 
-                emit(*n.expr);
+                emit(n.expr);
 
                 //  emit == and != as infix a ? b operators (since we don't have
                 //  any checking/instrumentation we want to do for those)
@@ -3292,7 +3763,7 @@ public:
                     emit(op);
                 }
 
-                emit(*n.terms.front().expr);
+                emit(n.terms.front().expr);
 
                 if (flag_safe_comparisons) {
                     switch (op.type()) {
@@ -3319,7 +3790,7 @@ public:
                 auto found_eq = 0;  // ==
                 auto count    = 0;
 
-                auto const* lhs = n.expr.get();
+                auto const* lhs = &n.expr;
                 auto lhs_name = "_" + std::to_string(count);
 
                 auto lambda_capture = lhs_name + " = " + print_to_string(*lhs);
@@ -3369,7 +3840,7 @@ public:
                         }
                     }
 
-                    auto rhs_expr = print_to_string(*term.expr);
+                    auto rhs_expr = print_to_string(term.expr);
 
                     lambda_body += lhs_name;
 
@@ -3396,7 +3867,7 @@ public:
                     lambda_capture += ", " + rhs_name + " = " + rhs_expr;
                     lambda_body    += rhs_name;
 
-                    lhs = term.expr.get();
+                    lhs = &term.expr;
                     lhs_name = rhs_name;
 
                     if (flag_safe_comparisons) {
@@ -3441,9 +3912,9 @@ public:
         if (
             !n.terms.empty()
             && n.terms.front().op->type() == lexeme::Assignment
-            && n.expr->get_postfix_expression_node()
-            && n.expr->get_postfix_expression_node()->get_first_token_ignoring_this()
-            && *n.expr->get_postfix_expression_node()->get_first_token_ignoring_this() == "_"
+            && n.expr.get_postfix_expression_node()
+            && n.expr.get_postfix_expression_node()->get_first_token_ignoring_this()
+            && *n.expr.get_postfix_expression_node()->get_first_token_ignoring_this() == "_"
             )
         {
             printer.print_cpp2( "(void)", n.position() );
@@ -3451,7 +3922,7 @@ public:
         }
         else
         {
-            emit(*n.expr);
+            emit(n.expr);
         }
         suppress_move_from_last_use = false;
 
@@ -3511,7 +3982,7 @@ public:
                 )
             {
                 printer.print_cpp2( ".construct(", n.position() );
-                emit(*x.expr);
+                emit(x.expr);
                 printer.print_cpp2( ")", n.position() );
             }
             else
@@ -3527,7 +3998,7 @@ public:
                     emit(*x.op);
                 }
                 printer.print_cpp2(" ", n.position());
-                emit(*x.expr);
+                emit(x.expr);
             }
         }
     }
@@ -4795,6 +5266,8 @@ public:
     )
         -> void
     {
+        auto span = trace_span{ "emit", "emit", n.has_name() ? n.name()->as_string_view() : "(unnamed)" };
+
         //  Declarations are handled in multiple passes,
         //  but we only want to do the sema checks once
         if (
@@ -5843,7 +6316,7 @@ public:
     //-----------------------------------------------------------------------
     //  print_errors
     //
-    auto print_errors()
+    auto print_errors(std::ostream& o)
         -> void
     {
         if (!errors.empty()) {
@@ -5872,19 +6345,23 @@ public:
                 || error != *prev
                 )
             {
-                error.print(std::cerr, strip_path(sourcefile));
+                error.print(o, strip_path(sourcefile));
             }
             prev = &error;
         }
 
-        if (violates_lifetime_safety) {
-            std::cerr << "  ==> program violates lifetime safety guarantee - see previous errors\n";
+        if (
+            violates_lifetime_safety
+            || parser.has_lifetime_safety_violation()
+            )
+        {
+            o << "  ==> program violates lifetime safety guarantee - see previous errors\n";
         }
         if (violates_bounds_safety) {
-            std::cerr << "  ==> program violates bounds safety guarantee - see previous errors\n";
+            o << "  ==> program violates bounds safety guarantee - see previous errors\n";
         }
         if (violates_initialization_safety) {
-            std::cerr << "  ==> program violates initialization safety guarantee - see previous errors\n";
+            o << "  ==> program violates initialization safety guarantee - see previous errors\n";
         }
     }
 
@@ -5920,6 +6397,16 @@ public:
     }
 
 
+    //-----------------------------------------------------------------------
+    //  get_source_text: The source file's contents as loaded
+    //
+    auto get_source_text() const
+        -> std::string_view
+    {
+        return source.get_text();
+    }
+
+
     //-----------------------------------------------------------------------
     //  has_cpp1: pass through
     //
@@ -5938,6 +6425,44 @@ public:
     {
         return source.has_cpp2();
     }
+
+
+    //-----------------------------------------------------------------------
+    //  get_time_report: How long each step took, and the slowest declarations
+    //
+    auto get_time_report() const
+        -> time_report
+    {
+        auto ret   = timings;
+        auto decls = std::vector<time_report::declaration_time>{};
+        for (auto const& [decl, wall] : declaration_timings) {
+            assert(decl);
+            decls.push_back({
+                decl->has_name() ? decl->name()->to_string(true) : "(unnamed)",
+                sourcefile,
+                decl->position(),
+                wall
+            });
+        }
+        //  Break ties in source order, so the report is deterministic
+        std::sort(
+            decls.begin(),
+            decls.end(),
+            [](auto const& a, auto const& b) { return a.pos < b.pos; }
+        );
+        ret.add_declarations(std::move(decls));
+        return ret;
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  get_output_filenames: pass through
+    //
+    auto get_output_filenames() const
+        -> std::vector<std::string>
+    {
+        return printer.output_filenames();
+    }
 };
 
 }
@@ -5958,66 +6483,367 @@ static cmdline_processor::register_flag cmd_debug(
     []{ enable_debug_output_files = true; }
 );
 
-auto main(
-    int   argc,
-    char* argv[]
-)
-    -> int
+static auto flag_jobs = 1;
+static cmdline_processor::register_flag cmd_jobs(
+    9,
+    "jobs N",
+    "Translate up to N files in parallel (default is 1)",
+    nullptr,
+    [](std::string const& n) { flag_jobs = std::max(1, atoi(n.c_str())); }
+);
+
+
+static auto flag_cache_dir = std::string{};
+static cmdline_processor::register_flag cmd_cache_dir(
+    9,
+    "incremental directory",
+    "Skip unchanged inputs, reusing outputs cached in 'directory'",
+    nullptr,
+    [](std::string const& dir) { flag_cache_dir = dir; }
+);
+
+
+//-----------------------------------------------------------------------
+//
+//  translation_cache: on-disk cache of successful translations
+//
+//  An entry is keyed by everything that can affect the generated Cpp1:
+//  the cppfront version and build (build.info isn't regenerated for local
+//  builds, so it alone doesn't tell a rebuilt cppfront from the one that
+//  made an entry), the flags, the source filename (which appears in #line
+//  directives and determines the output filenames and include guards),
+//  and the source file's bytes. An entry records the output
+//  files' contents plus the status information translate() reports, so
+//  that a hit can skip load + lex + parse + sema + lower entirely.
+//
+//-----------------------------------------------------------------------
+//
+class translation_cache
 {
-    cmdline.set_args(argc, argv);
-    cmdline.process_flags();
+public:
+    struct output_file {
+        std::string filename;
+        std::string contents;
+    };
 
-    if (cmdline.help_was_requested()) {
-        return EXIT_SUCCESS;
-    }
+    struct entry {
+        bool                                 has_cpp1 = false;
+        bool                                 has_cpp2 = false;
+        cppfront::lower_to_cpp1_ret          count    = {};
+        std::vector<output_file>             outputs  = {};
+    };
 
-    if (cmdline.arguments().empty()) {
-        std::cerr << "cppfront: error: no input files (try -help)\n";
-        return EXIT_FAILURE;
+private:
+    std::string           key    = {};  // the complete key text
+    std::string           digest = {};  // the part of the key for the source's bytes
+    std::filesystem::path path   = {};  // the entry file, named by the key's hash
+
+    //  64-bit FNV-1a, continued from 'h'
+    static auto hash(
+        std::string_view s,
+        std::uint64_t    h = 14695981039346656037ull
+    )
+        -> std::uint64_t
+    {
+        for (auto c : s) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ull;
+        }
+        return h;
     }
 
-    //  For each Cpp2 source file
-    int exit_status = EXIT_SUCCESS;
-    for (auto const& arg : cmdline.arguments())
+    static auto source_digest(std::string_view source)
+        -> std::string
     {
-        std::cout << arg.text << "...";
+        return std::to_string(std::ssize(source)) + " " + std::to_string(hash(source));
+    }
 
-        //  Load + lex + parse + sema
-        cppfront c(arg.text);
+    static auto read_file(std::filesystem::path const& filename)
+        -> std::optional<std::string>
+    {
+        auto in = std::ifstream{ filename, std::ios::binary };
+        if (!in) {
+            return {};
+        }
+        auto ss = std::ostringstream{};
+        ss << in.rdbuf();
+        return std::move(ss).str();
+    }
 
-        //  Generate Cpp1 (this may catch additional late errors)
-        auto count = c.lower_to_cpp1();
+    static auto write_file(
+        std::filesystem::path const& filename,
+        std::string_view             contents
+    )
+        -> bool
+    {
+        auto out = std::ofstream{ filename, std::ios::binary };
+        out.write(contents.data(), std::ssize(contents));
+        out.close();
+        return !out.fail();
+    }
 
-        //  If there were no errors, say so and generate Cpp1
-        if (c.had_no_errors())
-        {
-            if (!c.has_cpp1()) {
-                std::cout << " ok (all Cpp2, passes safety checks)\n";
+public:
+    //-----------------------------------------------------------------------
+    //  Constructor
+    //
+    //  sourcefile  the source file to be processed
+    //
+    translation_cache(std::string const& sourcefile)
+    {
+        //  Read it the same way cppfront will load it (see was_made_from)
+        auto source = mapped_file{};
+        if (!source.open(sourcefile, map_source_files)) {
+            return;
+        }
+        digest = source_digest(source.view());
+
+        key = std::string{cmdline.version()} + " (built " __DATE__ " " __TIME__ ")\n";
+        for (auto const& flag : cmdline.flags_used()) {
+            //  These affect only how we run and what we report on the
+            //  console, not what we generate
+            if (
+                !flag.starts_with("jobs=")
+                && !flag.starts_with("incremental=")
+                && !flag.starts_with("trace=")
+                && flag != "time-report"
+                && flag != "verbose"
+                )
+            {
+                key += flag + "\n";
             }
-            else if (c.has_cpp2()) {
-                std::cout << " ok (mixed Cpp1/Cpp2, Cpp2 code passes safety checks)\n";
+        }
+        key += sourcefile + "\n";
+        key += digest + "\n";
+
+        auto name = std::ostringstream{};
+        name << std::hex << std::setw(16) << std::setfill('0') << hash(key) << ".cpp2cache";
+        path = std::filesystem::path{flag_cache_dir} / name.str();
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  lookup: If there's a valid entry for this key, restore its outputs
+    //
+    //  Returns the entry if the outputs were restored
+    //
+    auto lookup() const
+        -> std::optional<entry>
+    {
+        if (path.empty()) {
+            return {};
+        }
+        auto in = std::ifstream{ path, std::ios::binary };
+        if (!in) {
+            return {};
+        }
+
+        auto read_string = [&](std::size_t size) {
+            auto ret = std::string(size, '\0');
+            in.read(ret.data(), __as<std::streamsize>(size));
+            return ret;
+        };
+
+        //  The stored key must match exactly, not just its hash
+        auto key_size = std::size_t{};
+        in >> key_size;
+        in.get();
+        if (!in || key_size != key.size() || read_string(key_size) != key) {
+            return {};
+        }
+
+        auto ret       = entry{};
+        auto n_outputs = 0;
+        in >> ret.has_cpp1 >> ret.has_cpp2 >> ret.count.cpp1_lines >> ret.count.cpp2_lines >> n_outputs;
+        for (auto i = 0; in && i < n_outputs; ++i)
+        {
+            auto filename_size = std::size_t{};
+            auto contents_size = std::size_t{};
+            in >> filename_size >> contents_size;
+            in.get();
+            auto filename = read_string(filename_size);
+            auto contents = read_string(contents_size);
+            ret.outputs.push_back({ std::move(filename), std::move(contents) });
+        }
+        if (!in) {
+            return {};
+        }
+
+        for (auto const& output : ret.outputs) {
+            if (!write_file(output.filename, output.contents)) {
+                return {};
             }
-            else {
-                std::cout << " ok (all Cpp1)\n";
+        }
+        return ret;
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  was_made_from: Whether the key was made from these source bytes
+    //
+    //  cppfront loads the source again after the key is made, so this says
+    //  whether what it translated is what the key says (the file could have
+    //  changed in between), and so whether it can be stored
+    //
+    auto was_made_from(std::string_view loaded_source) const
+        -> bool
+    {
+        return !path.empty() && source_digest(loaded_source) == digest;
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  store: Record a successful translation that wrote output_filenames
+    //
+    //  This is best-effort; if the entry can't be written, we just won't
+    //  get a hit next time. Entries are written to a temporary file and
+    //  then renamed, so concurrent cppfronts never see a partial entry.
+    //
+    auto store(
+        entry                           e,
+        std::vector<std::string> const& output_filenames
+    ) const
+        -> void
+    {
+        if (path.empty()) {
+            return;
+        }
+
+        for (auto const& filename : output_filenames) {
+            auto contents = read_file(filename);
+            if (!contents) {
+                return;
             }
+            e.outputs.push_back({ filename, std::move(*contents) });
+        }
 
-            if (flag_verbose) {
-                std::cout << "   Cpp1: " << count.cpp1_lines << " lines\n";
-                std::cout << "   Cpp2: " << count.cpp2_lines << " lines";
-                if (count.cpp1_lines + count.cpp2_lines > 0) {
-                    std::cout << " (" << 100 * count.cpp2_lines / (count.cpp1_lines + count.cpp2_lines) << "%)";
-                }
-                std::cout << "\n";
+        auto data = std::to_string(key.size()) + "\n" + key;
+        data += std::to_string(e.has_cpp1) + " " + std::to_string(e.has_cpp2) + " "
+            + std::to_string(e.count.cpp1_lines) + " " + std::to_string(e.count.cpp2_lines) + " "
+            + std::to_string(std::ssize(e.outputs)) + "\n";
+        for (auto const& output : e.outputs) {
+            data += std::to_string(output.filename.size()) + " " + std::to_string(output.contents.size()) + "\n";
+            data += output.filename;
+            data += output.contents;
+        }
+
+        auto ec = std::error_code{};
+        std::filesystem::create_directories(flag_cache_dir, ec);
+
+        auto temp = path;
+        temp += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()))
+            + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+        if (write_file(temp, data)) {
+            std::filesystem::rename(temp, path, ec);
+        }
+        if (ec || std::filesystem::exists(temp)) {
+            std::filesystem::remove(temp, ec);
+        }
+    }
+};
+
+
+//-----------------------------------------------------------------------
+//  print_success: Report a successful translation
+//
+auto print_success(
+    std::ostream&                  out,
+    translation_cache::entry const& result
+)
+    -> void
+{
+    if (!result.has_cpp1) {
+        out << " ok (all Cpp2, passes safety checks)\n";
+    }
+    else if (result.has_cpp2) {
+        out << " ok (mixed Cpp1/Cpp2, Cpp2 code passes safety checks)\n";
+    }
+    else {
+        out << " ok (all Cpp1)\n";
+    }
+
+    if (flag_verbose) {
+        auto const& count = result.count;
+        out << "   Cpp1: " << count.cpp1_lines << " lines\n";
+        out << "   Cpp2: " << count.cpp2_lines << " lines";
+        if (count.cpp1_lines + count.cpp2_lines > 0) {
+            out << " (" << 100 * count.cpp2_lines / (count.cpp1_lines + count.cpp2_lines) << "%)";
+        }
+        out << "\n";
+    }
+
+    out << "\n";
+}
+
+
+//-----------------------------------------------------------------------
+//  translate: Load + lex + parse + sema + lower one Cpp2 source file
+//
+//  filename    the source file to be processed
+//  out         where to write the status messages
+//  err         where to write the diagnostics
+//  timings     where to add the -time-report information
+//
+//  Returns EXIT_SUCCESS or EXIT_FAILURE
+//
+auto translate(
+    std::string const& filename,
+    std::ostream&      out,
+    std::ostream&      err,
+    time_report&       timings
+)
+    -> int
+{
+    auto span = trace_span{ "file", filename };
+
+    out << filename << "...";
+
+    //  If we're caching, first see if we already have the answer
+    //  (but not for -debug, which needs the real compiler data
+    //  structures, or stdout, which has no output file to restore)
+    auto cache = std::optional<translation_cache>{};
+    if (
+        !flag_cache_dir.empty()
+        && !enable_debug_output_files
+        && flag_cpp1_filename != "stdout"
+        )
+    {
+        cache.emplace(filename);
+        if (auto hit = cache->lookup()) {
+            print_success(out, *hit);
+            if (flag_time_report) {
+                out << "   (restored from the -incremental cache)\n\n";
+                ++timings.files;
             }
+            return EXIT_SUCCESS;
+        }
+    }
 
-            std::cout << "\n";
+    auto exit_status      = EXIT_SUCCESS;
+    auto result           = translation_cache::entry{};
+    auto output_filenames = std::vector<std::string>{};
+    auto cacheable        = false;
+    {
+        //  Load + lex + parse + sema
+        cppfront c(filename);
+
+        //  Generate Cpp1 (this may catch additional late errors)
+        result.count = c.lower_to_cpp1();
+
+        //  If there were no errors, say so and generate Cpp1
+        if (c.had_no_errors())
+        {
+            result.has_cpp1  = c.has_cpp1();
+            result.has_cpp2  = c.has_cpp2();
+            output_filenames = c.get_output_filenames();
+            cacheable        = cache && cache->was_made_from(c.get_source_text());
+            print_success(out, result);
         }
         //  Otherwise, print the errors
         else
         {
-            std::cerr << "\n";
-            c.print_errors();
-            std::cerr << "\n";
+            err << "\n";
+            c.print_errors(err);
+            err << "\n";
             exit_status = EXIT_FAILURE;
         }
 
@@ -6025,6 +6851,717 @@ auto main(
         if (enable_debug_output_files) {
             c.debug_print();
         }
+
+        //  And the timing information
+        if (flag_time_report) {
+            auto file_timings = c.get_time_report();
+            file_timings.print(out);
+            out << "\n";
+            timings += file_timings;
+        }
+    }
+
+    //  Now that no tokens refer to them, release this thread's generated
+    //  text, lines, lexers, and symbols, rather than let them build up
+    //  over all the files this thread translates
+    reset_generated_storage();
+
+    //  Now that the outputs are closed, remember them for next time
+    if (cacheable) {
+        cache->store(std::move(result), output_filenames);
     }
+
     return exit_status;
 }
+
+
+//-----------------------------------------------------------------------
+//  translate_in_parallel: Translate the files on up to 'jobs' threads
+//
+//  Each cppfront instance owns its own source, tokens, parser, and sema,
+//  so files are independent; only the console output needs ordering.
+//  Each file's output is buffered and then written in argument order as
+//  soon as it and all the files before it have finished.
+//
+auto translate_in_parallel(
+    std::vector<std::string> const& filenames,
+    int                             jobs,
+    std::ostream&                   out,
+    std::ostream&                   err,
+    time_report&                    timings
+)
+    -> int
+{
+    struct result {
+        std::ostringstream out;
+        std::ostringstream err;
+        time_report        timings;
+        int                exit_status = EXIT_SUCCESS;
+        std::promise<void> done;
+    };
+    auto results = std::vector<result>(filenames.size());
+    auto next    = std::atomic<int>{0};
+
+    auto worker = [&] {
+        for (
+            auto i = next++;
+            i < std::ssize(filenames);
+            i = next++
+            )
+        {
+            auto& r = results[i];
+            try {
+                r.exit_status = translate(filenames[i], r.out, r.err, r.timings);
+            }
+            catch (std::exception const& e) {
+                r.err << "\n" << filenames[i] << ": internal compiler error: " << e.what() << "\n\n";
+                r.exit_status = EXIT_FAILURE;
+            }
+            r.done.set_value();
+        }
+    };
+
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < std::min(jobs, __as<int>(std::ssize(filenames))); ++i) {
+        threads.emplace_back(worker);
+    }
+
+    int exit_status = EXIT_SUCCESS;
+    for (auto& r : results)
+    {
+        r.done.get_future().wait();
+        out << r.out.str() << std::flush;
+        err << r.err.str() << std::flush;
+        timings += r.timings;
+        if (r.exit_status != EXIT_SUCCESS) {
+            exit_status = r.exit_status;
+        }
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+    return exit_status;
+}
+
+
+static auto flag_trace_filename = std::string{};
+static cmdline_processor::register_flag cmd_trace(
+    9,
+    "trace filename",
+    "Write a Chrome/Perfetto trace of the translation to 'filename'",
+    nullptr,
+    [](std::string const& name) { flag_trace_filename = name; }
+);
+
+
+//-----------------------------------------------------------------------
+//  write_trace: Write the recorded spans as Chrome trace event JSON
+//
+auto write_trace(
+    std::string const&                filename,
+    std::vector<tracer::event> const& events
+)
+    -> bool
+{
+    auto json_string = [](std::string_view s) {
+        auto ret = std::string{"\""};
+        for (auto c : s) {
+            if (c == '"' || c == '\\') {
+                ret += '\\';
+                ret += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof buf, "\\u%04x", c);
+                ret += buf;
+            }
+            else {
+                ret += c;
+            }
+        }
+        return ret + "\"";
+    };
+
+    auto out = std::ofstream{filename};
+    out << "{\"traceEvents\":[";
+    auto comma = "\n";
+    for (auto const& e : events) {
+        out << comma << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+            << ",\"cat\":" << json_string(e.category)
+            << ",\"name\":" << json_string(e.name)
+            << std::fixed << std::setprecision(3)
+            << ",\"ts\":" << e.start_us
+            << ",\"dur\":" << e.duration_us << "}";
+        comma = ",\n";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    out.close();
+    return !out.fail();
+}
+
+
+//-----------------------------------------------------------------------
+//  run: Translate the files named on the (already processed) command line
+//
+auto run(
+    std::ostream& out,
+    std::ostream& err
+)
+    -> int
+{
+    if (cmdline.help_was_requested()) {
+        return EXIT_SUCCESS;
+    }
+
+    if (cmdline.arguments().empty()) {
+        err << "cppfront: error: no input files (try -help)\n";
+        return EXIT_FAILURE;
+    }
+
+    if (!flag_trace_filename.empty()) {
+        tracing.enable();
+    }
+
+    int  exit_status = EXIT_SUCCESS;
+    auto timings     = time_report{};
+    auto batch_start = std::chrono::steady_clock::now();
+
+    //  When translating several files with -jobs, use a worker pool
+    //  (but not if they're all writing to stdout, which would interleave)
+    if (
+        flag_jobs > 1
+        && std::ssize(cmdline.arguments()) > 1
+        && flag_cpp1_filename != "stdout"
+        )
+    {
+        auto filenames = std::vector<std::string>{};
+        for (auto const& arg : cmdline.arguments()) {
+            filenames.push_back(arg.text);
+        }
+        exit_status = translate_in_parallel(filenames, flag_jobs, out, err, timings);
+    }
+
+    //  Otherwise, translate each Cpp2 source file in turn
+    else
+    {
+        for (auto const& arg : cmdline.arguments())
+        {
+            if (translate(arg.text, out, err, timings) != EXIT_SUCCESS) {
+                exit_status = EXIT_FAILURE;
+            }
+        }
+    }
+
+    //  For a batch, also report the totals (the sum of the steps'
+    //  times can exceed the elapsed time if we ran -jobs in parallel)
+    if (
+        flag_time_report
+        && timings.files > 1
+        )
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - batch_start
+        );
+        out << "Total for " << timings.files << " files (" << elapsed.count() << " ms elapsed)\n";
+        timings.print(out);
+        out << "\n";
+    }
+
+    if (!flag_trace_filename.empty())
+    {
+        tracing.enable(false);
+        if (!write_trace(flag_trace_filename, tracing.take_events())) {
+            err << "cppfront: error: could not write trace file " << flag_trace_filename << "\n";
+            exit_status = EXIT_FAILURE;
+        }
+    }
+
+    return exit_status;
+}
+
+
+//===========================================================================
+//  Compile server
+//
+//  With -server, cppfront reads requests from stdin and writes responses
+//  to stdout; with -listen, it does the same for each connection to a
+//  Unix-domain socket. Either way, one process stays warm and handles the
+//  requests one at a time, reusing the flag registrations and storage.
+//
+//  A request is one line of space-separated fields, each of which may be
+//  written in double quotes (with \" and \\ escapes). The first field is
+//  the working directory for the request; the rest are exactly the
+//  arguments that would be given to cppfront on the command line:
+//
+//      /home/me/proj -p -o out/a.cpp src/a.cpp2
+//
+//  The response is a header line "<exit status> <out size> <err size>",
+//  followed by that many bytes of console output and of diagnostics.
+//
+//  With -use-server, cppfront is a client shim that sends its own command
+//  line to the server on a socket and reproduces the response as if it
+//  had run locally, so build systems can use it just like the normal CLI.
+//  If no server is running, the shim just does the work itself.
+//
+//===========================================================================
+//
+
+static auto flag_server = false;
+static cmdline_processor::register_flag cmd_server(
+    9,
+    "server",
+    "Run as a compile server for requests on stdin",
+    []{ flag_server = true; }
+);
+
+static auto flag_listen = std::string{};
+static cmdline_processor::register_flag cmd_listen(
+    9,
+    "listen socket",
+    "Run as a compile server for requests on Unix socket 'socket'",
+    nullptr,
+    [](std::string const& name) { flag_listen = name; }
+);
+
+static auto flag_use_server = std::string{};
+static cmdline_processor::register_flag cmd_use_server(
+    9,
+    "use-server socket",
+    "Have the compile server on Unix socket 'socket' do the work",
+    nullptr,
+    [](std::string const& name) { flag_use_server = name; }
+);
+
+
+//-----------------------------------------------------------------------
+//  flag_settings: A snapshot of all the flags, so the compile server can
+//  give each request the server's own settings as a starting point
+//
+struct flag_settings
+{
+    bool                     clean_cpp1           = flag_clean_cpp1;
+    bool                     cpp2_only            = flag_cpp2_only;
+    bool                     safe_null_pointers   = flag_safe_null_pointers;
+    bool                     safe_subscripts      = flag_safe_subscripts;
+    bool                     safe_comparisons     = flag_safe_comparisons;
+    bool                     use_source_location  = flag_use_source_location;
+    std::string              cpp1_filename        = flag_cpp1_filename;
+    bool                     print_colon_errors   = flag_print_colon_errors;
+    bool                     verbose              = flag_verbose;
+    bool                     no_exceptions        = flag_no_exceptions;
+    bool                     no_rtti              = flag_no_rtti;
+    bool                     debug_output_files   = enable_debug_output_files;
+    int                      jobs                 = flag_jobs;
+    std::string              cache_dir            = flag_cache_dir;
+    bool                     time_report          = flag_time_report;
+    std::string              trace_filename       = flag_trace_filename;
+    std::size_t              parallel_load_size   = flag_parallel_load_size;
+    int                      parallel_lex_sections = flag_parallel_lex_sections;
+    bool                     fused_lex            = flag_fused_lex;
+    bool                     defer_function_bodies = flag_defer_function_bodies;
+    int                      parallel_parse       = flag_parallel_parse;
+    int                      threads              = parallel_threads_override;
+    std::vector<std::string> flags_used           = cmdline.flags_used();
+
+    auto restore() const
+        -> void
+    {
+        flag_clean_cpp1           = clean_cpp1;
+        flag_cpp2_only            = cpp2_only;
+        flag_safe_null_pointers   = safe_null_pointers;
+        flag_safe_subscripts      = safe_subscripts;
+        flag_safe_comparisons     = safe_comparisons;
+        flag_use_source_location  = use_source_location;
+        flag_cpp1_filename        = cpp1_filename;
+        flag_print_colon_errors   = print_colon_errors;
+        flag_verbose              = verbose;
+        flag_no_exceptions        = no_exceptions;
+        flag_no_rtti              = no_rtti;
+        enable_debug_output_files = debug_output_files;
+        flag_jobs                 = jobs;
+        flag_cache_dir            = cache_dir;
+        flag_time_report          = time_report;
+        flag_trace_filename       = trace_filename;
+        flag_parallel_load_size   = parallel_load_size;
+        flag_parallel_lex_sections = parallel_lex_sections;
+        flag_fused_lex            = fused_lex;
+        flag_defer_function_bodies = defer_function_bodies;
+        flag_parallel_parse       = parallel_parse;
+        parallel_threads_override = threads;
+        cmdline.set_flags_used(flags_used);
+    }
+};
+
+
+//-----------------------------------------------------------------------
+//  Request encoding helpers
+//
+auto quote_request_field(std::string_view field)
+    -> std::string
+{
+    auto ret = std::string{"\""};
+    for (auto c : field) {
+        if (c == '"' || c == '\\') {
+            ret += '\\';
+        }
+        ret += c;
+    }
+    return ret + "\"";
+}
+
+auto split_request(std::string_view line)
+    -> std::vector<std::string>
+{
+    auto ret = std::vector<std::string>{};
+    auto i   = 0;
+    while (i < std::ssize(line))
+    {
+        if (std::isspace(static_cast<unsigned char>(line[i]))) {
+            ++i;
+            continue;
+        }
+
+        auto field = std::string{};
+        if (line[i] == '"') {
+            for (++i; i < std::ssize(line) && line[i] != '"'; ++i) {
+                if (line[i] == '\\' && i+1 < std::ssize(line)) {
+                    ++i;
+                }
+                field += line[i];
+            }
+            ++i;    // skip the closing "
+        }
+        else {
+            for (; i < std::ssize(line) && !std::isspace(static_cast<unsigned char>(line[i])); ++i) {
+                field += line[i];
+            }
+        }
+        ret.push_back(std::move(field));
+    }
+    return ret;
+}
+
+
+//-----------------------------------------------------------------------
+//  handle_request: Run one compile server request
+//
+//  fields      the request's working directory and command line arguments
+//  out         where to write the status messages
+//  err         where to write the diagnostics
+//
+//  Returns the exit status a standalone cppfront would have returned
+//
+auto handle_request(
+    std::vector<std::string> const& fields,
+    std::ostream&                   out,
+    std::ostream&                   err
+)
+    -> int
+{
+    if (fields.empty()) {
+        err << "cppfront: error: empty compile server request\n";
+        return EXIT_FAILURE;
+    }
+
+    auto ec = std::error_code{};
+    std::filesystem::current_path(fields.front(), ec);
+    if (ec) {
+        err << "cppfront: error: cannot change to directory " << fields.front() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    flag_server     = false;
+    flag_listen     = {};
+    flag_use_server = {};
+
+    cmdline_out = &out;
+    cmdline.set_args({ fields.begin()+1, fields.end() });
+    cmdline.process_flags();
+
+    auto exit_status = EXIT_FAILURE;
+    if (
+        flag_server
+        || !flag_listen.empty()
+        || !flag_use_server.empty()
+        )
+    {
+        err << "cppfront: error: a compile server request cannot start or use a server\n";
+    }
+    else if (flag_cpp1_filename == "stdout") {
+        err << "cppfront: error: a compile server request cannot output to stdout\n";
+    }
+    else {
+        try {
+            exit_status = run(out, err);
+        }
+        catch (std::exception const& e) {
+            err << "cppfront: internal compiler error: " << e.what() << "\n";
+        }
+    }
+
+    cmdline_out = &std::cout;
+    return exit_status;
+}
+
+
+//-----------------------------------------------------------------------
+//  serve: Handle requests from 'in' until it ends, responding on 'out'
+//
+auto serve(
+    std::istream& in,
+    std::ostream& out
+)
+    -> void
+{
+    auto const defaults  = flag_settings{};
+    auto const directory = std::filesystem::current_path();
+    map_source_files = false;
+
+    auto line = std::string{};
+    while (std::getline(in, line))
+    {
+        if (line.empty()) {
+            continue;
+        }
+
+        auto request_out = std::ostringstream{};
+        auto request_err = std::ostringstream{};
+        auto exit_status = handle_request(split_request(line), request_out, request_err);
+
+        //  Get ready for the next request (translate has already released
+        //  each file's generated storage)
+        defaults.restore();
+        auto ec = std::error_code{};
+        std::filesystem::current_path(directory, ec);
+
+        auto response_out = std::move(request_out).str();
+        auto response_err = std::move(request_err).str();
+        out << exit_status << " " << response_out.size() << " " << response_err.size() << "\n"
+            << response_out << response_err << std::flush;
+    }
+}
+
+
+#ifndef _WIN32
+
+//-----------------------------------------------------------------------
+//  socket_streambuf: Minimal stream buffer for a connected socket
+//
+class socket_streambuf : public std::streambuf
+{
+    int  fd;
+    char buffer[4096];
+
+    auto write_all(char const* s, std::streamsize n)
+        -> bool
+    {
+        while (n > 0) {
+            auto written = ::write(fd, s, __as<std::size_t>(n));
+            if (written <= 0) {
+                return false;
+            }
+            s += written;
+            n -= written;
+        }
+        return true;
+    }
+
+protected:
+    auto underflow()
+        -> int_type override
+    {
+        auto n = ::read(fd, buffer, sizeof buffer);
+        if (n <= 0) {
+            return traits_type::eof();
+        }
+        setg(buffer, buffer, buffer + n);
+        return traits_type::to_int_type(buffer[0]);
+    }
+
+    auto overflow(int_type c)
+        -> int_type override
+    {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        auto ch = traits_type::to_char_type(c);
+        return write_all(&ch, 1) ? c : traits_type::eof();
+    }
+
+    auto xsputn(char const* s, std::streamsize n)
+        -> std::streamsize override
+    {
+        return write_all(s, n) ? n : 0;
+    }
+
+public:
+    socket_streambuf(int fd_)
+        : fd{fd_}
+    {
+        setg(buffer, buffer, buffer);
+    }
+};
+
+
+auto make_socket_address(std::string const& name)
+    -> std::optional<sockaddr_un>
+{
+    auto addr = sockaddr_un{};
+    if (name.size() >= sizeof addr.sun_path) {
+        return {};
+    }
+    addr.sun_family = AF_UNIX;
+    std::copy(name.begin(), name.end(), addr.sun_path);
+    return addr;
+}
+
+
+//-----------------------------------------------------------------------
+//  listen_on: Serve each connection to the Unix-domain socket in turn
+//
+auto listen_on(std::string const& name)
+    -> int
+{
+    auto addr = make_socket_address(name);
+    auto fd   = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (!addr || fd < 0) {
+        std::cerr << "cppfront: error: cannot create socket " << name << "\n";
+        return EXIT_FAILURE;
+    }
+
+    //  Replace any stale socket left behind by a previous server
+    ::unlink(name.c_str());
+    if (
+        ::bind(fd, reinterpret_cast<sockaddr const*>(&*addr), sizeof *addr) != 0
+        || ::listen(fd, SOMAXCONN) != 0
+        )
+    {
+        std::cerr << "cppfront: error: cannot listen on socket " << name << "\n";
+        ::close(fd);
+        return EXIT_FAILURE;
+    }
+
+    //  A client that goes away early shouldn't take the server with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    while (true)
+    {
+        auto connection = ::accept(fd, nullptr, nullptr);
+        if (connection < 0) {
+            continue;
+        }
+        auto buf    = socket_streambuf{connection};
+        auto stream = std::iostream{&buf};
+        serve(stream, stream);
+        ::close(connection);
+    }
+}
+
+
+//-----------------------------------------------------------------------
+//  use_server: Send a command line to the server, and report its response
+//
+//  Returns the server's exit status, or nullopt if there's no server
+//
+auto use_server(
+    std::string const&              name,
+    std::vector<std::string> const& args
+)
+    -> std::optional<int>
+{
+    auto addr = make_socket_address(name);
+    auto fd   = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (!addr || fd < 0) {
+        return {};
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr const*>(&*addr), sizeof *addr) != 0) {
+        ::close(fd);
+        return {};
+    }
+
+    auto request = quote_request_field(std::filesystem::current_path().string());
+    for (auto const& arg : args) {
+        request += " " + quote_request_field(arg);
+    }
+    request += "\n";
+
+    auto buf    = socket_streambuf{fd};
+    auto stream = std::iostream{&buf};
+    stream << request << std::flush;
+    ::shutdown(fd, SHUT_WR);
+
+    auto exit_status = EXIT_FAILURE;
+    auto out_size    = std::size_t{};
+    auto err_size    = std::size_t{};
+    stream >> exit_status >> out_size >> err_size;
+    stream.get();
+
+    auto response_out = std::string(out_size, '\0');
+    auto response_err = std::string(err_size, '\0');
+    stream.read(response_out.data(), __as<std::streamsize>(out_size));
+    stream.read(response_err.data(), __as<std::streamsize>(err_size));
+    ::close(fd);
+
+    if (!stream) {
+        return {};
+    }
+    std::cout << response_out << std::flush;
+    std::cerr << response_err << std::flush;
+    return exit_status;
+}
+
+#endif
+
+
+auto main(
+    int   argc,
+    char* argv[]
+)
+    -> int
+{
+    cmdline.set_args(argc, argv);
+    cmdline.process_flags();
+
+    if (
+        !flag_listen.empty()
+        || !flag_use_server.empty()
+        )
+    {
+#ifdef _WIN32
+        std::cerr << "cppfront: error: Unix socket compile servers are not supported on this platform\n";
+        return EXIT_FAILURE;
+#else
+        if (!flag_listen.empty()) {
+            return listen_on(flag_listen);
+        }
+
+        //  Forward our command line, except for the -use-server option itself
+        auto args = std::vector<std::string>{};
+        for (auto i = 1; i < argc; ++i) {
+            auto arg = std::string_view{argv[i]};
+            if (
+                (arg.starts_with("-u") || arg.starts_with("/u"))
+                && i+1 < argc
+                && argv[i+1] == flag_use_server
+                )
+            {
+                ++i;
+                continue;
+            }
+            args.emplace_back(arg);
+        }
+        if (auto exit_status = use_server(flag_use_server, args)) {
+            return *exit_status;
+        }
+        //  Otherwise there's no server, so just do it ourselves
+#endif
+    }
+
+    if (flag_server) {
+        serve(std::cin, std::cout);
+        return EXIT_SUCCESS;
+    }
+
+    return run(std::cout, std::cerr);
+}
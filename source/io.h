@@ -23,10 +23,44 @@
 #include <ostream>
 #include <iterator>
 #include <cctype>
+#include <cerrno>
+
+#include <bit>
+#include <future>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 
 namespace cpp2 {
 
+//---------------------------------------------------------------------------
+//  parallel_threads: how many threads to split work across when loading,
+//  lexing, or parsing in parallel
+//
+//  That's the hardware's concurrency, unless parallel_threads_override is
+//  set (e.g., so that the parallel paths run on a machine with one core)
+//
+static auto parallel_threads_override = 0;
+
+auto parallel_threads()
+    -> int
+{
+    if (parallel_threads_override > 0) {
+        return parallel_threads_override;
+    }
+    return int(std::thread::hardware_concurrency());
+}
+
+
 //---------------------------------------------------------------------------
 //  move_next: advances i as long as p(line[i]) is true or the end of line
 //
@@ -35,7 +69,7 @@ namespace cpp2 {
 //  p       predicate to apply
 //
 auto move_next(
-    std::string const& line,
+    std::string_view   line,
     int&               i,
     auto               p
 )
@@ -61,7 +95,7 @@ auto move_next(
 //
 //  line    current line being processed
 //
-auto peek_first_non_whitespace(std::string const& line)
+auto peek_first_non_whitespace(std::string_view line)
     -> char
 {
     auto i = 0;
@@ -87,7 +121,7 @@ struct is_preprocessor_ret {
     bool has_continuation;
 };
 auto is_preprocessor(
-    std::string const& line,
+    std::string_view   line,
     bool               first_line
 )
     -> is_preprocessor_ret
@@ -102,7 +136,7 @@ auto is_preprocessor(
     }
 
     //  return true iff last character is a \ continuation
-    return { true, line.back() == '\\' };
+    return { true, !line.empty() && line.back() == '\\' };
 }
 
 
@@ -111,7 +145,7 @@ auto is_preprocessor(
 //
 //  line    current line being processed
 //
-auto starts_with_import(std::string const& line)
+auto starts_with_import(std::string_view line)
     -> bool
 {
     auto i = 0;
@@ -138,7 +172,7 @@ auto starts_with_import(std::string const& line)
 //
 //  line    current line being processed
 //
-auto starts_with_whitespace_slash_slash(std::string const& line)
+auto starts_with_whitespace_slash_slash(std::string_view line)
     -> bool
 {
     auto i = 0;
@@ -161,7 +195,7 @@ auto starts_with_whitespace_slash_slash(std::string const& line)
 //
 //  line    current line being processed
 //
-auto starts_with_whitespace_slash_star_and_no_star_slash(std::string const& line)
+auto starts_with_whitespace_slash_star_and_no_star_slash(std::string_view line)
     -> bool
 {
     auto i = 0;
@@ -278,7 +312,7 @@ auto starts_with_operator(std::string_view s)
 //
 //  line    current line being processed
 //
-auto starts_with_identifier_colon(std::string const& line)
+auto starts_with_identifier_colon(std::string_view line)
     -> bool
 {
     auto i = 0;
@@ -479,6 +513,83 @@ public:
 };
 
 
+//-----------------------------------------------------------------------
+//
+//  braces_recorder: Records the braces_tracker calls that would be made
+//  for a run of lines, so they can be replayed later into the real
+//  braces_tracker once the brace depth at the start of the run is known
+//
+//  Used by source::load to classify chunks of big files in parallel
+//
+//-----------------------------------------------------------------------
+//
+class braces_recorder
+{
+public:
+    enum class kind : std::uint8_t {
+        open_brace, close_brace, pre_if, pre_else, pre_endif
+    };
+    struct event {
+        kind            what;
+        source_position pos;    // the line is relative to the first recorded line
+    };
+
+private:
+    std::vector<event> events;
+
+public:
+    auto found_open_brace(lineno_t lineno) -> void {
+        events.push_back({ kind::open_brace, source_position(lineno, 0) });
+    }
+
+    auto found_close_brace(source_position pos) -> void {
+        events.push_back({ kind::close_brace, pos });
+    }
+
+    auto found_pre_if   () -> void { events.push_back({ kind::pre_if,    {} }); }
+    auto found_pre_else () -> void { events.push_back({ kind::pre_else,  {} }); }
+    auto found_pre_endif() -> void { events.push_back({ kind::pre_endif, {} }); }
+
+    auto size() const -> int {
+        return std::ssize(events);
+    }
+
+    //  Replay events [first,last) into 'braces', where the first recorded
+    //  line is really line number 'first_lineno'
+    //
+    auto replay(
+        braces_tracker& braces,
+        int             first,
+        int             last,
+        lineno_t        first_lineno
+    ) const
+        -> void
+    {
+        assert(0 <= first && first <= last && last <= size());
+        for (auto i = first; i < last; ++i)
+        {
+            auto pos = events[i].pos;
+            pos.lineno += first_lineno;
+
+            switch (events[i].what) {
+            break;case kind::open_brace:
+                braces.found_open_brace(pos.lineno);
+            break;case kind::close_brace:
+                braces.found_close_brace(pos);
+            break;case kind::pre_if:
+                braces.found_pre_if();
+            break;case kind::pre_else:
+                braces.found_pre_else();
+            break;case kind::pre_endif:
+                braces.found_pre_endif();
+            break;default:
+                assert(false);
+            }
+        }
+    }
+};
+
+
 //---------------------------------------------------------------------------
 //  starts_with_preprocessor_if_else_endif: the line starts with a preprocessor conditional
 //
@@ -488,7 +599,7 @@ enum class preprocessor_conditional {
     none = 0, pre_if, pre_else, pre_endif
 };
 auto starts_with_preprocessor_if_else_endif(
-    std::string const& line
+    std::string_view line
 )
     -> preprocessor_conditional
 {
@@ -532,18 +643,81 @@ auto starts_with_preprocessor_if_else_endif(
 //  in_comment          track whether we're in a comment
 //  in_string_literal   track whether we're in a string literal
 //
+//  Most characters can't change any of that state -- only R " { } * /
+//  can -- so we skip runs of the others quickly, 16 or 32 at a time
+//  where SSE2 or AVX2 is available
+//
+auto is_cpp1_state_char(char c)
+    -> bool
+{
+    switch (c) {
+    break;case 'R': case '"': case '{': case '}': case '*': case '/':
+        return true;
+    break;default:
+        return false;
+    }
+}
+
+auto find_cpp1_state_char(
+    std::string_view line,
+    std::size_t      i
+)
+    -> std::size_t
+{
+#if defined(__AVX2__)
+    for (; i + 32 <= line.size(); i += 32)
+    {
+        auto chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(line.data() + i));
+        auto found = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_or_si256( _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('R')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')) ),
+                _mm256_or_si256( _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('}')) )
+            ),
+            _mm256_or_si256( _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('*')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('/')) )
+        );
+        if (auto mask = static_cast<unsigned>(_mm256_movemask_epi8(found))) {
+            return i + std::countr_zero(mask);
+        }
+    }
+#endif
+#if defined(CPP2_USE_SSE2)
+    for (; i + 16 <= line.size(); i += 16)
+    {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(line.data() + i));
+        auto found = _mm_or_si128(
+            _mm_or_si128(
+                _mm_or_si128( _mm_cmpeq_epi8(chunk, _mm_set1_epi8('R')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')) ),
+                _mm_or_si128( _mm_cmpeq_epi8(chunk, _mm_set1_epi8('{')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('}')) )
+            ),
+            _mm_or_si128( _mm_cmpeq_epi8(chunk, _mm_set1_epi8('*')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('/')) )
+        );
+        if (auto mask = static_cast<unsigned>(_mm_movemask_epi8(found))) {
+            return i + std::countr_zero(mask);
+        }
+    }
+#endif
+    while (
+        i < line.size()
+        && !is_cpp1_state_char(line[i])
+        )
+    {
+        ++i;
+    }
+    return i;
+}
+
 struct process_line_ret {
     bool all_comment_line;
     bool empty_line;
     bool all_rawstring_line;
 };
 auto process_cpp_line(
-    std::string const&  line,
+    std::string_view    line,
     bool&               in_comment,
     bool&               in_string_literal,
     bool&               in_raw_string_literal,
     std::string&        raw_string_closing_seq,
-    braces_tracker&     braces,
+    auto&               braces,     // a braces_tracker or braces_recorder
     lineno_t            lineno
 )
     -> process_line_ret
@@ -568,6 +742,31 @@ auto process_cpp_line(
     auto prev = ' ';
     for (auto i = colno_t{0}; i < ssize(line); ++i)
     {
+        //  Skip any run of characters that can't change our state, which
+        //  only has the effects that processing them one at a time would
+        //
+        if (!in_raw_string_literal)
+        {
+            auto end = __as<colno_t>(find_cpp1_state_char(line, __as<std::size_t>(i)));
+            if (end > i)
+            {
+                for (auto j = i; r.empty_line && j < end; ++j) {
+                    if (!isspace(line[j])) {
+                        r.empty_line = false;
+                    }
+                }
+                if (!in_comment || in_string_literal) {
+                    r.all_comment_line   = false;
+                    r.all_rawstring_line = false;
+                }
+                prev = line[end-1];
+                i    = end;
+                if (i == ssize(line)) {
+                    break;
+                }
+            }
+        }
+
         //  Local helper functions for readability
         //  Note: in_literal is for { and } and so doesn't have to work for escaped ' characters
         //
@@ -618,7 +817,7 @@ auto process_cpp_line(
                                 paren_pos != std::string::npos
                                 )
                             {
-                                raw_string_closing_seq = ")"+line.substr(i, paren_pos-i)+"\"";
+                                raw_string_closing_seq = ")"+std::string{line.substr(i, paren_pos-i)}+"\"";
                                 in_raw_string_literal = true;
                             }
                         }
@@ -691,7 +890,7 @@ auto process_cpp_line(
 //  Returns:    whether additional lines should be inspected
 //
 auto process_cpp2_line(
-    std::string const&        line,
+    std::string_view          line,
     bool&                     in_comment,
     braces_tracker&           braces,
     lineno_t                  lineno,
@@ -762,6 +961,416 @@ auto process_cpp2_line(
 }
 
 
+//---------------------------------------------------------------------------
+//  cpp1_state: The Cpp1 lexical state that carries over from one line to
+//  the next, see process_cpp_line
+//
+struct cpp1_state {
+    bool        in_comment            = false;
+    bool        in_string_literal     = false;
+    bool        in_raw_string_literal = false;
+    std::string raw_string_closing_seq;
+
+    auto operator==(cpp1_state const&) const -> bool = default;
+};
+
+
+//---------------------------------------------------------------------------
+//  split_next_line: split the next line off the front of 'remaining'
+//
+//  Each line is a view of the text up to (but not including) the next
+//  '\n', the same lines std::getline would give
+//
+auto split_next_line(
+    std::string_view& remaining,
+    std::string_view& line
+)
+    -> bool
+{
+    if (remaining.empty()) {
+        return false;
+    }
+    auto end = remaining.find('\n');
+    if (end == remaining.npos) {
+        line      = remaining;
+        remaining = {};
+    }
+    else {
+        line = remaining.substr(0, end);
+        remaining.remove_prefix(end+1);
+    }
+    return true;
+}
+
+
+//---------------------------------------------------------------------------
+//  track_preprocessor_conditional: tell 'braces' about a preprocessor line
+//  that is an #if/#else/#endif
+//
+auto track_preprocessor_conditional(
+    std::string_view line,
+    auto&            braces
+)
+    -> void
+{
+    switch (starts_with_preprocessor_if_else_endif(line)) {
+    break;case preprocessor_conditional::pre_if:
+        braces.found_pre_if();
+    break;case preprocessor_conditional::pre_else:
+        braces.found_pre_else();
+    break;case preprocessor_conditional::pre_endif:
+        braces.found_pre_endif();
+    break;default:
+        ;
+    }
+}
+
+
+//---------------------------------------------------------------------------
+//  classify_cpp1_line: the category of a line that is in Cpp1 code and is
+//  not a preprocessor line
+//
+auto classify_cpp1_line(
+    std::string_view line,
+    cpp1_state&      state,
+    auto&            braces,
+    lineno_t         lineno
+)
+    -> source_line::category
+{
+    if (starts_with_import(line)) {
+        return source_line::category::import;
+    }
+
+    auto stats = process_cpp_line(
+        line,
+        state.in_comment,
+        state.in_string_literal,
+        state.in_raw_string_literal,
+        state.raw_string_closing_seq,
+        braces,
+        lineno
+    );
+    if (stats.all_comment_line) {
+        return source_line::category::comment;
+    }
+    else if (stats.all_rawstring_line) {
+        return source_line::category::rawstring;
+    }
+    else if (stats.empty_line) {
+        return source_line::category::empty;
+    }
+    return source_line::category::cpp1;
+}
+
+
+//-----------------------------------------------------------------------
+//
+//  speculative_chunk: A chunk of a big source file, classified as Cpp1
+//  ahead of time (in parallel with the other chunks) assuming some state
+//  at the start of the chunk
+//
+//  The assumption can be wrong in two ways, and source::load checks both
+//  when it reaches the chunk:
+//
+//    - The real state at the start of the chunk could be different, in
+//      which case this speculation isn't used
+//
+//    - A line could start a Cpp2 declaration, which depends on the real
+//      brace depth; so we record the brace events instead of tracking
+//      depth, and record each line that could start a Cpp2 declaration
+//      so that the speculation can be cut short there
+//
+//-----------------------------------------------------------------------
+//
+struct speculative_chunk
+{
+    //  A line that starts Cpp2 code if it's at brace depth 0
+    struct cpp2_candidate {
+        int        line;            // index into lines
+        int        brace_events;    // number of brace events before the line
+        cpp1_state state;           // state at the start of the line
+    };
+
+    cpp1_state                  entry_state;
+    cpp1_state                  exit_state;
+    std::vector<source_line>    lines;
+    braces_recorder             braces;
+    std::vector<cpp2_candidate> cpp2_candidates;
+    int                         first_cpp1_line = -1;   // -1 if none
+
+    //-----------------------------------------------------------------------
+    //  classify: Classify the lines of 'text' starting in 'entry', with the
+    //            same logic as source::load apart from Cpp2 detection
+    //
+    auto classify(
+        std::string_view text,
+        cpp1_state       entry
+    )
+        -> void
+    {
+        entry_state = entry;
+        auto state  = std::move(entry);
+        auto line   = std::string_view{};
+
+        auto add_preprocessor_line = [&] {
+            if (first_cpp1_line < 0) {
+                first_cpp1_line = std::ssize(lines);
+            }
+            lines.push_back({ line, source_line::category::preprocessor });
+            track_preprocessor_conditional(line, braces);
+        };
+
+        while (split_next_line(text, line))
+        {
+            auto lineno = lineno_t(std::ssize(lines));
+
+            if (auto pre = is_preprocessor(line, true);
+                pre.is_preprocessor
+                && !state.in_comment
+                && !state.in_raw_string_literal
+                )
+            {
+                add_preprocessor_line();
+                while (
+                    pre.has_continuation
+                    && split_next_line(text, line)
+                    )
+                {
+                    add_preprocessor_line();
+                    pre = is_preprocessor(line, false);
+                }
+            }
+
+            else
+            {
+                if (!state.in_comment
+                    && !state.in_raw_string_literal
+                    && starts_with_identifier_colon(line)
+                    )
+                {
+                    cpp2_candidates.push_back({ lineno, braces.size(), state });
+                }
+
+                auto cat = classify_cpp1_line(line, state, braces, lineno);
+                if (
+                    cat == source_line::category::cpp1
+                    && first_cpp1_line < 0
+                    )
+                {
+                    first_cpp1_line = lineno;
+                }
+                lines.push_back({ line, cat });
+            }
+        }
+
+        exit_state = std::move(state);
+    }
+};
+
+
+//---------------------------------------------------------------------------
+//  split_into_chunks: split 'text' into about 'count' chunks to classify
+//  in parallel, each starting at the beginning of a line that does not
+//  continue a preprocessor line
+//
+auto split_into_chunks(
+    std::string_view text,
+    int              count
+)
+    -> std::vector<std::string_view>
+{
+    auto ret   = std::vector<std::string_view>{};
+    auto start = std::size_t{0};
+
+    for (auto i = 1; i < count; ++i)
+    {
+        auto end = std::max(start, text.size() / count * i);
+        while (
+            (end = text.find('\n', end)) != text.npos
+            && end > 0
+            && text[end-1] == '\\'
+            )
+        {
+            ++end;
+        }
+        if (end == text.npos || end+1 >= text.size()) {
+            break;
+        }
+        ++end;
+        if (end > start) {
+            ret.push_back(text.substr(start, end-start));
+            start = end;
+        }
+    }
+
+    ret.push_back(text.substr(start));
+    return ret;
+}
+
+
+//-----------------------------------------------------------------------
+//
+//  mapped_file: The read-only contents of a file, memory-mapped where
+//               possible so that the source lines can be views into it
+//               with no copying and no per-line allocation
+//
+//-----------------------------------------------------------------------
+//
+class mapped_file
+{
+    std::string_view contents = {};
+    std::string      buffer   = {};     // used if the file isn't mapped
+#ifndef _WIN32
+    void*            mapping  = nullptr;
+#endif
+
+public:
+    mapped_file() = default;
+
+    ~mapped_file()
+    {
+#ifndef _WIN32
+        if (mapping) {
+            munmap(mapping, contents.size());
+        }
+#endif
+    }
+
+    //-----------------------------------------------------------------------
+    //  open: Make the contents of 'filename' available
+    //
+    //  may_map     false to read the contents into memory even where
+    //              the file could be mapped
+    //
+    auto open(
+        std::string const& filename,
+        bool               may_map = true
+    )
+        -> bool
+    {
+#ifndef _WIN32
+        auto fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (
+            may_map
+            && fstat(fd, &st) == 0
+            && S_ISREG(st.st_mode)
+            && st.st_size > 0
+            )
+        {
+            auto p = mmap(nullptr, __as<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                close(fd);
+                mapping  = p;
+                contents = { static_cast<char const*>(p), __as<std::size_t>(st.st_size) };
+                return true;
+            }
+        }
+        close(fd);
+#endif
+
+        //  Otherwise (e.g., on Windows, where this also gives us the usual
+        //  text-mode newline translation) just read it in one go
+        std::ifstream in{ filename };
+        if (!in.is_open()) {
+            return false;
+        }
+        buffer.assign( std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() );
+        contents = buffer;
+        return true;
+    }
+
+    auto view() const
+        -> std::string_view
+    {
+        return contents;
+    }
+
+    //  No copying
+    //
+    mapped_file(mapped_file const&)            = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+    mapped_file(mapped_file&&)                 = delete;
+    mapped_file& operator=(mapped_file&&)      = delete;
+};
+
+
+//-----------------------------------------------------------------------
+//  copy_whole_file: Overwrite 'to' with the contents of 'from', expected
+//  to be 'size' bytes, as an in-kernel copy where the platform has one
+//
+//  Returns false if that wasn't possible (including if 'from' isn't
+//  'size' bytes long), and then the caller should write the contents
+//  itself
+//
+auto copy_whole_file(
+    std::string const& from,
+    std::string const& to,
+    std::size_t        size
+)
+    -> bool
+{
+#ifdef __linux__
+    auto in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (
+        ::fstat(in, &st) != 0
+        || !S_ISREG(st.st_mode)
+        || std::size_t(st.st_size) != size
+        )
+    {
+        ::close(in);
+        return false;
+    }
+
+    auto out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    //  Prefer copy_file_range, which can share extents on some file
+    //  systems, and fall back to sendfile where it isn't supported
+    //  (both advance the same file offsets, so they can be mixed)
+    auto left                = size;
+    auto use_copy_file_range = true;
+    while (left > 0)
+    {
+        auto n = use_copy_file_range
+            ? ::copy_file_range(in, nullptr, out, nullptr, left, 0)
+            : ::sendfile(out, in, nullptr, left);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && use_copy_file_range) {
+            use_copy_file_range = false;
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        left -= std::size_t(n);
+    }
+
+    ::close(in);
+    return ::close(out) == 0 && left == 0;
+#else
+    (void)from;
+    (void)to;
+    (void)size;
+    return false;
+#endif
+}
+
+
 //-----------------------------------------------------------------------
 //
 //  source: Represents a program source file
@@ -771,27 +1380,30 @@ auto process_cpp2_line(
 class source
 {
     std::vector<error_entry>& errors;
+    mapped_file               file;         // the lines are views into this
     std::vector<source_line>  lines;
     bool                      cpp1_found = false;
     bool                      cpp2_found = false;
-
-    static const int max_line_len = 90'000;
-        //  do not reduce this - I encountered an 80,556-char
-        //  line in real world code during testing
-    char buf[max_line_len];
+    bool                      may_map    = true;
 
 public:
     //-----------------------------------------------------------------------
     //  Constructor
     //
     //  errors      error list
+    //  may_map     false if the file will be overwritten while its lines
+    //              are still in use (e.g., when the output file is also
+    //              the input file), so it must be read into memory instead
+    //              of mapped, since reading a mapped file after it has been
+    //              truncated faults
     //
     source(
-        std::vector<error_entry>& errors_
+        std::vector<error_entry>& errors_,
+        bool                      may_map_ = true
     )
         : errors{ errors_ }
         , lines( 1 )        // extra blank to avoid off-by-one everywhere
-        , buf{0}
+        , may_map{ may_map_ }
     {
     }
 
@@ -818,75 +1430,205 @@ public:
     //  load: Read a line-by-line view of 'filename', preserving line breaks
     //
     //  filename                the source file to be loaded
-    //  source                  program textual representation
+    //  parallel_min_size       files at least this big (in bytes) are split
+    //                          into chunks that are classified in parallel
+    //  find_definition_end     called for each line of a Cpp2 definition
+    //                          (with the lines so far, the last being that
+    //                          line, and the comment state, brace tracker, and
+    //                          errors) to say whether it ends the definition;
+    //                          by default process_cpp2_line, and see also
+    //                          tokens::fused_lexer
     //
+    static constexpr auto default_parallel_min_size = std::size_t{4*1024*1024};
+
     auto load(
-        std::string const&  filename
+        std::string const&  filename,
+        std::size_t         parallel_min_size = default_parallel_min_size
     )
         -> bool
     {
-        std::ifstream in{ filename };
-        if (!in.is_open()) {
+        return load(
+            filename,
+            parallel_min_size,
+            [](auto& lines, bool& in_comment, auto& braces, auto& errors) {
+                return process_cpp2_line(
+                    lines.back().text,
+                    in_comment,
+                    braces,
+                    std::ssize(lines)-1,
+                    errors
+                );
+            }
+        );
+    }
+
+    auto load(
+        std::string const&  filename,
+        std::size_t         parallel_min_size,
+        auto&&              find_definition_end
+    )
+        -> bool
+    {
+        if (!file.open(filename, may_map)) {
             return false;
         }
 
-        auto in_comment            = false;
-        auto in_string_literal     = false;
-        auto in_raw_string_literal = false;
-        std::string raw_string_closing_seq;
+        auto remaining = file.view();
+        auto text      = std::string_view{};
+        auto next_line = [&]() -> bool {
+            return split_next_line(remaining, text);
+        };
 
+        auto state  = cpp1_state{};
         auto braces = braces_tracker(errors);
 
         auto add_preprocessor_line = [&] {
-            lines.push_back({ &buf[0], source_line::category::preprocessor });
-            if (auto pre = starts_with_preprocessor_if_else_endif(lines.back().text);
-                pre != preprocessor_conditional::none
+            lines.push_back({ text, source_line::category::preprocessor });
+            track_preprocessor_conditional(text, braces);
+        };
+
+        //  For a big file, classify each chunk after the first one in parallel
+        //  while we work through the file, speculating that the chunk starts
+        //  either in normal code or in a /* */ comment
+        //
+        //  Starting inside a string literal or raw string literal is rare
+        //  enough at a line break that we don't speculate on it, and if that
+        //  happens the chunk just gets processed normally below
+        //
+        struct chunk {
+            std::string_view                            text;
+            std::vector<std::future<speculative_chunk>> speculations;
+        };
+        auto chunks = std::vector<chunk>{};
+
+        if (
+            auto threads = parallel_threads();
+            remaining.size() >= parallel_min_size
+            && threads > 1
+            )
+        {
+            auto chunk_texts = split_into_chunks(remaining, threads);
+            for (auto i = 1; i < std::ssize(chunk_texts); ++i)
+            {
+                auto& c = chunks.emplace_back(chunk_texts[i]);
+                for (auto in_comment : { false, true }) {
+                    auto entry = cpp1_state{};
+                    entry.in_comment = in_comment;
+                    c.speculations.push_back( std::async(
+                        std::launch::async,
+                        [text = c.text, entry] {
+                            auto ret = speculative_chunk{};
+                            ret.classify(text, entry);
+                            return ret;
+                        }
+                    ) );
+                }
+            }
+        }
+        auto next_chunk = chunks.begin();
+
+        while (true)
+        {
+            //  If we're at the start of a chunk that was classified ahead of
+            //  time in the state we're really in, take its lines as far as
+            //  the first Cpp2 code (if any)
+            //
+            while (
+                next_chunk != chunks.end()
+                && next_chunk->text.data() < remaining.data()
+                )
+            {
+                ++next_chunk;
+            }
+            if (
+                next_chunk != chunks.end()
+                && next_chunk->text.data() == remaining.data()
                 )
             {
-                switch (pre) {
-                break;case preprocessor_conditional::pre_if:
-                    braces.found_pre_if();
-                break;case preprocessor_conditional::pre_else:
-                    braces.found_pre_else();
-                break;case preprocessor_conditional::pre_endif:
-                    braces.found_pre_endif();
-                break;default:
-                    assert(false);
+                auto& c = *next_chunk++;
+                for (auto& speculation : c.speculations)
+                {
+                    auto spec = speculation.get();
+                    if (spec.entry_state != state) {
+                        continue;
+                    }
+
+                    auto base        = lineno_t(std::ssize(lines));
+                    auto lines_taken = std::ssize(spec.lines);
+                    auto events      = 0;
+                    state            = spec.exit_state;
+
+                    for (auto const& candidate : spec.cpp2_candidates)
+                    {
+                        spec.braces.replay(braces, events, candidate.brace_events, base);
+                        events = candidate.brace_events;
+                        if (braces.current_depth() < 1) {
+                            lines_taken = candidate.line;
+                            state       = candidate.state;
+                            break;
+                        }
+                    }
+                    if (lines_taken == std::ssize(spec.lines)) {
+                        spec.braces.replay(braces, events, spec.braces.size(), base);
+                    }
+
+                    if (
+                        spec.first_cpp1_line >= 0
+                        && spec.first_cpp1_line < lines_taken
+                        )
+                    {
+                        cpp1_found = true;
+                    }
+                    lines.insert(
+                        lines.end(),
+                        spec.lines.begin(),
+                        spec.lines.begin() + lines_taken
+                    );
+
+                    //  Continue from the first line not taken
+                    auto resume =
+                        lines_taken < std::ssize(spec.lines)
+                            ? spec.lines[lines_taken].text.data()
+                            : c.text.data() + c.text.size();
+                    remaining = file.view().substr( resume - file.view().data() );
+                    break;
                 }
+                continue;
             }
-        };
 
-        while (in.getline(&buf[0], max_line_len)) {
+            if (!next_line()) {
+                break;
+            }
 
             //  Handle preprocessor source separately, they're outside the language
             //
-            if (auto pre = is_preprocessor(buf, true);
+            if (auto pre = is_preprocessor(text, true);
                 pre.is_preprocessor
-                && !in_comment
-                && !in_raw_string_literal
+                && !state.in_comment
+                && !state.in_raw_string_literal
                 )
             {
                 cpp1_found = true;
                 add_preprocessor_line();
                 while (
                     pre.has_continuation
-                    && in.getline(&buf[0], max_line_len)
+                    && next_line()
                     )
                 {
                     add_preprocessor_line();
-                    pre = is_preprocessor(buf, false);
+                    pre = is_preprocessor(text, false);
                 }
             }
 
             else
             {
-                lines.push_back({ &buf[0], source_line::category::cpp1 });
+                lines.push_back({ text, source_line::category::cpp1 });
 
                 //  Switch to cpp2 mode if we're not in a comment, not inside nested { },
                 //  and the line starts with "nonwhitespace :" but not "::"
                 //
-                if (!in_comment
-                    && !in_raw_string_literal
+                if (!state.in_comment
+                    && !state.in_raw_string_literal
                     && braces.current_depth() < 1
                     && starts_with_identifier_colon(lines.back().text)
                     )
@@ -909,17 +1651,11 @@ public:
 
                     //  Find the end of the definition:
                     while (
-                        !process_cpp2_line(
-                            lines.back().text,
-                            in_comment,
-                            braces,
-                            std::ssize(lines)-1,
-                            errors
-                        )
-                        && in.getline(&buf[0], max_line_len)
+                        !find_definition_end(lines, state.in_comment, braces, errors)
+                        && next_line()
                         )
                     {
-                        lines.push_back({ &buf[0], source_line::category::cpp2 });
+                        lines.push_back({ text, source_line::category::cpp2 });
                     }
                 }
 
@@ -927,68 +1663,35 @@ public:
                 //
                 else
                 {
-                    if (starts_with_import(lines.back().text)) {
-                        lines.back().cat = source_line::category::import;
-                    }
-                    else {
-                        auto stats = process_cpp_line(
-                            lines.back().text,
-                            in_comment,
-                            in_string_literal,
-                            in_raw_string_literal,
-                            raw_string_closing_seq,
-                            braces,
-                            std::ssize(lines) - 1
-                        );
-                        if (stats.all_comment_line) {
-                            lines.back().cat = source_line::category::comment;
-                        }
-                        else if (stats.all_rawstring_line) {
-                            lines.back().cat = source_line::category::rawstring;
-                        }
-                        else if (stats.empty_line) {
-                            lines.back().cat = source_line::category::empty;
-                        }
-                        else {
-                            cpp1_found = true;
-                        }
+                    lines.back().cat = classify_cpp1_line(
+                        lines.back().text,
+                        state,
+                        braces,
+                        std::ssize(lines) - 1
+                    );
+                    if (lines.back().cat == source_line::category::cpp1) {
+                        cpp1_found = true;
                     }
                 }
 
             }
         }
 
-        //  Because I encountered very long lines in real-world code during testing
-        //
-        if (in.gcount() >= max_line_len-1)
-        {
-            errors.emplace_back(
-                source_position(lineno_t(std::ssize(lines)), 0),
-                std::string("source line too long - length must be less than ")
-                    + std::to_string(max_line_len)
-            );
-            return false;
-        }
-
-        //  This shouldn't be possible, so check it anyway
-        //
-        if (!in.eof())
-        {
-            errors.emplace_back(
-                source_position(lineno_t(std::ssize(lines)), 0),
-                std::string("unexpected error reading source lines - did not reach EOF"),
-                false,
-                true    // a noisy fallback error
-            );
-            return false;
-        }
-
         braces.found_eof( source_position(lineno_t(std::ssize(lines)), 0) );
 
         return true;
     }
 
 
+    //-----------------------------------------------------------------------
+    //  get_text: Access the whole loaded file
+    //
+    auto get_text() const -> std::string_view
+    {
+        return file.view();
+    }
+
+
     //-----------------------------------------------------------------------
     //  get_lines: Access the source lines
     //
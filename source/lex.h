@@ -20,8 +20,12 @@
 
 #include "io.h"
 #include <map>
+#include <array>
+#include <span>
 #include <climits>
 #include <deque>
+#include <memory>
+#include <limits>
 #include <cstring>
 
 
@@ -209,6 +213,94 @@ auto is_operator(lexeme l)
 }
 
 
+//-----------------------------------------------------------------------
+//
+//  symbol_table: interns the names (identifiers and keywords) seen in a
+//  translation unit, giving each distinct name a dense nonzero id so that
+//  name tokens can be compared by id instead of by text
+//
+//-----------------------------------------------------------------------
+//
+using symbol_id = std::uint32_t;
+
+auto is_name(lexeme l)
+    -> bool
+{
+    return l == lexeme::Identifier
+        || l == lexeme::Keyword
+        || l == lexeme::Cpp1MultiKeyword
+        || l == lexeme::Cpp2FixedType;
+}
+
+class symbol_table
+{
+    //  The names are copied here, since a token's text can be a view of a
+    //  file that goes away before the table does
+    std::deque<std::string>                         names;
+    std::unordered_map<std::string_view, symbol_id> ids;
+
+public:
+    //  Ids must fit in the token's 24 bits; past that, names just aren't
+    //  interned and get compared by text
+    static constexpr auto max_id = symbol_id{(1 << 24) - 1};
+
+    auto intern(std::string_view name)
+        -> symbol_id
+    {
+        if (auto i = ids.find(name); i != ids.end()) {
+            return i->second;
+        }
+        if (std::ssize(names) >= max_id) {
+            return 0;
+        }
+        auto id = unsafe_narrow<symbol_id>(std::ssize(names) + 1);
+        ids.emplace(names.emplace_back(name), id);
+        return id;
+    }
+
+    //  The id of a name already seen, or 0 if it hasn't been
+    auto find(std::string_view name) const
+        -> symbol_id
+    {
+        if (auto i = ids.find(name); i != ids.end()) {
+            return i->second;
+        }
+        return 0;
+    }
+
+    auto text(symbol_id id) const
+        -> std::string_view
+    {
+        assert (0 < id && id <= std::ssize(names));
+        return names[id-1];
+    }
+
+    auto size() const
+        -> int
+    {
+        return std::ssize(names);
+    }
+
+    auto clear()
+        -> void
+    {
+        ids.clear();
+        names.clear();
+    }
+};
+
+//  Per-thread, like the generated text below, since a thread translates
+//  one file at a time, and cleared with it after each file (see
+//  reset_generated_storage, which translate calls), so a table holds
+//  only the names of the file being translated
+//
+//  A thread that lexes part of a file for another thread (see tokens::lex)
+//  sets 'symbols' to null while it does, and its tokens' names are interned
+//  by the thread that takes them over
+static thread_local auto this_thread_symbols = symbol_table{};
+static thread_local auto symbols             = &this_thread_symbols;
+
+
 //-----------------------------------------------------------------------
 //
 //  token: represents a single token
@@ -217,6 +309,12 @@ auto is_operator(lexeme l)
 //
 //-----------------------------------------------------------------------
 //
+//  A token is a view of its text plus where it came from. Translating
+//  large files makes millions of these, so keep them small: the text is a
+//  start pointer and a 32-bit length rather than a string_view, which with
+//  the position, the one-byte lexeme, and a name's 24-bit symbol id makes
+//  24 bytes instead of 32
+//
 class token
 {
 public:
@@ -226,10 +324,11 @@ public:
         source_position pos,
         lexeme          type
     )
-      : sv      {start, unsafe_narrow<ulong>(count)}
+      : start   {start}
       , pos     {pos}
-      , lex_type{type}
+      , count   {unsafe_narrow<std::uint32_t>(count)}
     {
+        set_type(type);
     }
 
     token(
@@ -237,17 +336,18 @@ public:
         source_position pos,
         lexeme          type
     )
-      : sv      {sz}
+      : start   {sz}
       , pos     {pos}
-      , lex_type{type}
+      , count   {unsafe_narrow<std::uint32_t>(std::strlen(sz))}
     {
+        set_type(type);
     }
 
     auto as_string_view() const
         -> std::string_view
     {
-        assert (sv.data());
-        return sv;
+        assert (start);
+        return {start, count};
     }
 
     operator std::string_view() const
@@ -255,9 +355,13 @@ public:
         return as_string_view();
     }
 
+    //  Names interned in the same table are equal iff their ids are
     auto operator== (token const& t) const
         -> bool
     {
+        if (sym && t.sym) {
+            return sym == t.sym;
+        }
         return operator std::string_view() == t.operator std::string_view();
     }
 
@@ -270,12 +374,12 @@ public:
     auto to_string( bool text_only = false ) const
         -> std::string
     {
-        auto text = std::string{sv};
+        auto text = std::string{as_string_view()};
         if (text_only) {
             return text;
         }
         else {
-            return __as<std::string>(lex_type) + std::string(": ") + text;
+            return __as<std::string>(type()) + std::string(": ") + text;
         }
     }
 
@@ -294,11 +398,19 @@ public:
 
     auto position() const -> source_position { return pos;       }
 
-    auto length  () const -> int             { return sv.size(); }
+    auto length  () const -> int             { return count;     }
 
-    auto type    () const -> lexeme          { return lex_type;  }
+    auto type    () const -> lexeme          { return lexeme(std::int8_t(lex_type)); }
 
-    auto set_type(lexeme l) -> void          { lex_type = l;     }
+    //  The name's id in this thread's symbol table, or 0 if it isn't a name
+    auto symbol  () const -> symbol_id       { return sym;       }
+
+    auto set_type(lexeme l)
+        -> void
+    {
+        lex_type = std::uint8_t(l);
+        sym      = is_name(l) && symbols ? symbols->intern(as_string_view()) : 0;
+    }
 
     auto visit(auto& v, int depth) const
         -> void
@@ -307,12 +419,15 @@ public:
     }
 
 private:
-    std::string_view sv;
+    char const*      start;
     source_position  pos;
-    lexeme           lex_type;
+    std::uint32_t    count;
+    std::uint32_t    sym      : 24;
+    std::uint32_t    lex_type : 8;
 };
 
 static_assert (CHAR_BIT == 8);
+static_assert (sizeof(void*) != 8 || sizeof(token) == 24);
 
 
 auto labelized_position(token const* t)
@@ -517,13 +632,160 @@ auto expand_raw_string_literal(
     return parts;
 }
 
+//-----------------------------------------------------------------------
+//
+//  keyword_table: The keywords lex_line recognizes, looked up with a
+//  perfect hash computed at compile time
+//
+//  A candidate word is hashed once and compared with at most one keyword,
+//  instead of being compared with each keyword in turn
+//
+//-----------------------------------------------------------------------
+//
+struct keyword_entry {
+    std::string_view text;
+    lexeme           type;
+};
+
+//  Where a keyword could be lexed in more than one way, the first entry
+//  wins (e.g., "int" is lexed as a Cpp1MultiKeyword so that it can be
+//  merged with adjacent fundamental type keywords like "unsigned")
+//
+constexpr keyword_entry keyword_entries[] = {
+
+    //  Cpp1 multi-token fundamental type keywords
+    {"char16_t", lexeme::Cpp1MultiKeyword}, {"char32_t", lexeme::Cpp1MultiKeyword},
+    {"char8_t",  lexeme::Cpp1MultiKeyword}, {"char",     lexeme::Cpp1MultiKeyword},
+    {"double",   lexeme::Cpp1MultiKeyword}, {"float",    lexeme::Cpp1MultiKeyword},
+    {"int",      lexeme::Cpp1MultiKeyword}, {"long",     lexeme::Cpp1MultiKeyword},
+    {"short",    lexeme::Cpp1MultiKeyword}, {"signed",   lexeme::Cpp1MultiKeyword},
+    {"unsigned", lexeme::Cpp1MultiKeyword},
+
+    //  Cpp2 fixed-width type alias keywords
+    {"i8",  lexeme::Cpp2FixedType}, {"i16", lexeme::Cpp2FixedType}, {"i32", lexeme::Cpp2FixedType},
+    {"i64", lexeme::Cpp2FixedType}, {"longdouble", lexeme::Cpp2FixedType}, {"longlong", lexeme::Cpp2FixedType},
+    {"u8",  lexeme::Cpp2FixedType}, {"u16", lexeme::Cpp2FixedType}, {"u32", lexeme::Cpp2FixedType},
+    {"u64", lexeme::Cpp2FixedType}, {"ulong", lexeme::Cpp2FixedType}, {"ulonglong", lexeme::Cpp2FixedType},
+    {"ushort", lexeme::Cpp2FixedType},
+
+    //  Other keywords
+    //
+    //  Cpp2 has a smaller set of the Cpp1 globally reserved keywords, but we continue to
+    //  reserve all the ones Cpp1 has both for compatibility and to not give up a keyword
+    //  Some keywords like "delete" and "union" are not in this list because we reject them elsewhere
+    //  Cpp2 also adds a couple, notably "is" and "as"
+    {"alignas", lexeme::Keyword}, {"alignof", lexeme::Keyword}, {"asm", lexeme::Keyword},
+    {"as", lexeme::Keyword}, {"auto", lexeme::Keyword},
+    {"bool", lexeme::Keyword}, {"break", lexeme::Keyword},
+    {"case", lexeme::Keyword}, {"catch", lexeme::Keyword}, {"co_await", lexeme::Keyword},
+    {"co_return", lexeme::Keyword}, {"co_yield", lexeme::Keyword}, {"concept", lexeme::Keyword},
+    {"const_cast", lexeme::Keyword}, {"consteval", lexeme::Keyword}, {"constexpr", lexeme::Keyword},
+    {"constinit", lexeme::Keyword}, {"const", lexeme::Keyword}, {"continue", lexeme::Keyword},
+    {"decltype", lexeme::Keyword}, {"default", lexeme::Keyword}, {"do", lexeme::Keyword},
+    {"dynamic_cast", lexeme::Keyword},
+    {"else", lexeme::Keyword}, {"enum", lexeme::Keyword}, {"explicit", lexeme::Keyword},
+    {"export", lexeme::Keyword}, {"extern", lexeme::Keyword},
+    {"for", lexeme::Keyword}, {"friend", lexeme::Keyword},
+    {"goto", lexeme::Keyword},
+    {"if", lexeme::Keyword}, {"import", lexeme::Keyword}, {"inline", lexeme::Keyword},
+    {"is", lexeme::Keyword},
+    {"module", lexeme::Keyword}, {"mutable", lexeme::Keyword},
+    {"namespace", lexeme::Keyword}, {"noexcept", lexeme::Keyword},
+    {"operator", lexeme::Keyword},
+    {"private", lexeme::Keyword}, {"protected", lexeme::Keyword}, {"public", lexeme::Keyword},
+    {"register", lexeme::Keyword}, {"reinterpret_cast", lexeme::Keyword}, {"requires", lexeme::Keyword},
+    {"return", lexeme::Keyword},
+    {"sizeof", lexeme::Keyword}, {"static_assert", lexeme::Keyword}, {"static_cast", lexeme::Keyword},
+    {"static", lexeme::Keyword}, {"switch", lexeme::Keyword},
+    {"template", lexeme::Keyword}, {"this", lexeme::Keyword}, {"thread_local", lexeme::Keyword},
+    {"throws", lexeme::Keyword}, {"throw", lexeme::Keyword}, {"try", lexeme::Keyword},
+    {"typedef", lexeme::Keyword}, {"typeid", lexeme::Keyword}, {"typename", lexeme::Keyword},
+    {"using", lexeme::Keyword},
+    {"virtual", lexeme::Keyword}, {"void", lexeme::Keyword}, {"volatile", lexeme::Keyword},
+    {"wchar_t", lexeme::Keyword}, {"while", lexeme::Keyword}
+};
+
+class keyword_table
+{
+    //  Each slot holds 1 + an index into keyword_entries, or 0 if empty
+    static constexpr auto slot_count   = 1024;
+    static constexpr auto max_length   = 16;    // longest keyword
+    static_assert(std::size(keyword_entries) < 255);
+
+    std::uint32_t                          seed  = 0;
+    std::array<std::uint8_t, slot_count>   slots = {};
+
+    static constexpr auto hash(std::string_view word, std::uint32_t seed)
+        -> std::uint32_t
+    {
+        //  FNV-1a, starting from the seed
+        auto h = seed ^ 2166136261u;
+        for (auto c : word) {
+            h = (h ^ std::uint8_t(c)) * 16777619u;
+        }
+        return (h ^ (h >> 16)) % slot_count;
+    }
+
+public:
+    //  Find a seed for which every keyword gets its own slot
+    //
+    consteval keyword_table()
+    {
+        for (seed = 0; ; ++seed)
+        {
+            slots = {};
+            auto collision = false;
+            for (auto i = 0; i < std::ssize(keyword_entries) && !collision; ++i)
+            {
+                auto& slot = slots[hash(keyword_entries[i].text, seed)];
+                collision = slot != 0;
+                slot = std::uint8_t(i + 1);
+            }
+            if (!collision) {
+                return;
+            }
+        }
+    }
+
+    //  Returns the keyword that is exactly 'word', or null if none
+    //
+    constexpr auto lookup(std::string_view word) const
+        -> keyword_entry const*
+    {
+        if (
+            word.size() < 2
+            || word.size() > max_length
+            )
+        {
+            return nullptr;
+        }
+        auto slot = slots[hash(word, seed)];
+        if (
+            slot != 0
+            && keyword_entries[slot-1].text == word
+            )
+        {
+            return &keyword_entries[slot-1];
+        }
+        return nullptr;
+    }
+};
+
+constexpr auto keywords = keyword_table{};
+
+static_assert(keywords.lookup("reinterpret_cast")->type == lexeme::Keyword);
+static_assert(keywords.lookup("unsigned")->type == lexeme::Cpp1MultiKeyword);
+static_assert(keywords.lookup("u8")->type == lexeme::Cpp2FixedType);
+static_assert(!keywords.lookup("interface"));
+
+
 //-----------------------------------------------------------------------
 //  lex: Tokenize a single line while maintaining inter-line state
 //
 //  mutable_line            the line to be tokenized
 //  lineno                  the current line number
 //  in_comment              are we currently in a comment
-//  current_comment         the current partial comment
+//  current_comment         the text so far of a comment that began on an earlier line
 //  current_comment_start   the current comment's start position
 //  tokens                  the token list to add to
 //  comments                the comment token list to add to
@@ -532,16 +794,104 @@ auto expand_raw_string_literal(
 //
 
 //  A stable place to store additional text for source tokens that are merged
-//  into a whitespace-containing token (to merge the Cpp1 multi-token keywords)
+//  into a whitespace-containing token (to merge the Cpp1 multi-token keywords),
+//  and for source lines that are rewritten while lexing them (to expand string
+//  interpolations) since a source_line's text is just a view of the file
 //  -- this isn't about tokens generated later, that's tokens::generated_tokens
-static auto generated_text  = std::deque<std::string>{};
-static auto generated_lines = std::deque<std::vector<source_line>>{};
+//
+//  Metafunctions store a lot of small strings here (every generated member
+//  is a string of source code), so it's a bump allocator: text is copied
+//  into large blocks, keeps its address until clear(), and clear() releases
+//  it all at once, keeping the first block for reuse
+//
+class text_arena
+{
+    static constexpr auto block_size = std::size_t{64 * 1024};
+
+    std::vector<std::unique_ptr<char[]>> blocks;    // each block_size
+    std::vector<std::unique_ptr<char[]>> large;     // text too big to share a block
+    std::vector<std::string_view>        entries;   // in the order stored
+    char*                                next = {};
+    std::size_t                          left = 0;
+
+public:
+    //  Copy s into the arena, returning the stable copy
+    //  (which is also null-terminated, for convenience)
+    //
+    //  listed  whether to include it when iterating over the arena's text,
+    //          which is how debug output lists the generated text
+    //
+    auto store(
+        std::string_view s,
+        bool             listed = true
+    )
+        -> std::string_view
+    {
+        auto needed = s.size() + 1;
+        auto dest   = next;
+
+        if (needed > block_size / 4) {
+            dest = large.emplace_back( std::make_unique<char[]>(needed) ).get();
+        }
+        else {
+            if (needed > left) {
+                next = blocks.emplace_back( std::make_unique<char[]>(block_size) ).get();
+                left = block_size;
+                dest = next;
+            }
+            next += needed;
+            left -= needed;
+        }
 
+        std::copy(s.begin(), s.end(), dest);
+        dest[s.size()] = '\0';
+        if (listed) {
+            entries.emplace_back(dest, s.size());
+        }
+        return {dest, s.size()};
+    }
 
-static auto multiline_raw_strings = std::deque<multiline_raw_string>{};
+    //  Take over another arena's text, which keeps its address
+    auto adopt(text_arena&& other)
+        -> void
+    {
+        auto take = [](auto& to, auto& from) {
+            to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+            from.clear();
+        };
+        take(blocks,  other.blocks);
+        take(large,   other.large);
+        take(entries, other.entries);
+        other.next = {};
+        other.left = 0;
+    }
+
+    auto begin() const { return entries.begin(); }
+    auto end  () const { return entries.end();   }
+
+    auto clear()
+        -> void
+    {
+        entries.clear();
+        large.clear();
+        blocks.resize( std::min(blocks.size(), std::size_t{1}) );
+        next = blocks.empty() ? nullptr : blocks.front().get();
+        left = blocks.empty() ? 0       : block_size;
+    }
+};
+
+//  These are per-thread so that several files can be translated concurrently
+static thread_local auto generated_text = text_arena{};
+
+//  Scratch space for the source_lines of code generated by metafunctions,
+//  reused for each fragment since the lines are only needed while lexing it
+static thread_local auto generated_lines = std::vector<source_line>{};
+
+
+static thread_local auto multiline_raw_strings = std::deque<multiline_raw_string>{};
 
 auto lex_line(
-    std::string&               mutable_line,
+    std::string_view&          mutable_line,
     int const                  lineno,
     bool&                      in_comment,
     std::string&               current_comment,
@@ -555,6 +905,18 @@ auto lex_line(
 {
     auto const& line = mutable_line;    // most accesses will be const, so give that the nice name
 
+    //  Rewrite part of the line, which first copies it to stable storage
+    auto replace_in_line = [&](
+        std::size_t      pos,
+        std::size_t      count,
+        std::string_view with
+    )
+    {
+        auto rewritten = std::string{mutable_line};
+        rewritten.replace( pos, count, with );
+        mutable_line = generated_text.store( rewritten );
+    };
+
     auto original_size = std::ssize(tokens);
 
     auto i = colno_t{0};
@@ -615,7 +977,7 @@ auto lex_line(
         auto is_double         = 0;
         auto is_signed         = 0;
         auto is_unsigned       = 0;
-        generated_text.push_back( "" );
+        auto merged            = std::string{};
         while(
             !tokens.empty()
             && tokens.back().type() == lexeme::Cpp1MultiKeyword
@@ -631,17 +993,18 @@ auto lex_line(
             if (text == "unsigned") { ++is_unsigned; }
 
             if (num_merged_tokens > 0) {
-                generated_text.back() = " " + generated_text.back();
+                merged = " " + merged;
             }
-            generated_text.back() = text + generated_text.back();
+            merged = text + merged;
             pos = tokens.back().position();
             tokens.pop_back();
             ++num_merged_tokens;
         }
 
+        auto text = generated_text.store( merged );
         tokens.push_back({
-            &generated_text.back()[0],
-            std::ssize(generated_text.back()),
+            text.data(),
+            std::ssize(text),
             pos,
             lexeme::Keyword
             });
@@ -699,14 +1062,14 @@ auto lex_line(
                 && (tokens[i].type() == lexeme::GreaterEq || tokens[i].type() == lexeme::Greater || tokens[i].type() == lexeme::Assignment))
             {
                 //  Merge all three tokens into an identifier
-                generated_text.push_back( "operator" + tokens[i-1].to_string(true) + tokens[i].to_string(true) );
+                auto name = generated_text.store( "operator" + tokens[i-1].to_string(true) + tokens[i].to_string(true) );
                 tokens.pop_back();
                 tokens.pop_back();
                 auto pos = tokens.back().position();
                 tokens.pop_back();
                 tokens.push_back({
-                    &generated_text.back()[0],
-                    std::ssize(generated_text.back()),
+                    name.data(),
+                    std::ssize(name),
                     pos,
                     lexeme::Identifier
                     });
@@ -716,7 +1079,7 @@ auto lex_line(
             else if (is_operator(tokens[i-1].type()))
             {
                 //  Merge just "operator" + the symbol into an identifier,
-                generated_text.push_back( "operator" + tokens[i-1].to_string(true) );
+                auto name = generated_text.store( "operator" + tokens[i-1].to_string(true) );
                 //  and preserve the last token separately
                 auto last_token = tokens.back();
 
@@ -725,8 +1088,8 @@ auto lex_line(
                 auto pos = tokens.back().position();
                 tokens.pop_back();
                 tokens.push_back({
-                    &generated_text.back()[0],
-                    std::ssize(generated_text.back()),
+                    name.data(),
+                    std::ssize(name),
                     pos,
                     lexeme::Identifier
                     });
@@ -740,15 +1103,15 @@ auto lex_line(
                 )
             {
                 //  Merge just "operator" + the symbols into an identifier,
-                generated_text.push_back( "operator" + tokens[i-1].to_string(true) + tokens[i].to_string(true) );
+                auto name = generated_text.store( "operator" + tokens[i-1].to_string(true) + tokens[i].to_string(true) );
 
                 tokens.pop_back();
                 tokens.pop_back();
                 auto pos = tokens.back().position();
                 tokens.pop_back();
                 tokens.push_back({
-                    &generated_text.back()[0],
-                    std::ssize(generated_text.back()),
+                    name.data(),
+                    std::ssize(name),
                     pos,
                     lexeme::Identifier
                     });
@@ -767,6 +1130,14 @@ auto lex_line(
             : '\0';
     };
 
+    //  Where the current comment's text starts on this line
+    auto comment_start_here = [&]() -> std::size_t {
+        return
+            current_comment_start.lineno == lineno
+            ? unsafe_narrow<std::size_t>(current_comment_start.colno - 1)
+            : 0;
+    };
+
     auto store = [&](auto num, lexeme type)
     {
         tokens.push_back({
@@ -928,71 +1299,12 @@ auto lex_line(
     //G     any Cpp1-and-Cpp2 keyword
     //G     one of: 'import' 'module' 'export' 'is' 'as'
     //G
-    auto do_is_keyword = [&](std::vector<std::string_view> const& r) {
-        auto remaining_line = std::string_view(line).substr(unsafe_narrow<std::size_t>(i));
-        auto m = std::find_if(r.begin(), r.end(), [&](std::string_view s) {
-            return remaining_line.starts_with(s);
-        });
-        if (m != r.end()) {
-            //  If we matched and what's next is EOL or a non-identifier char, we matched!
-            if (
-                i+std::ssize(*m) == std::ssize(line)                                            // EOL
-                || !is_identifier_continue(line[unsafe_narrow<std::size_t>(i)+std::size(*m)])   // non-identifier char
-                )
-            {
-                return static_cast<int>(std::ssize(*m));
-            }
-        }
-        return 0;
-    };
-
-    auto peek_is_keyword = [&]
-    {
-        //  Cpp2 has a smaller set of the Cpp1 globally reserved keywords, but we continue to
-        //  reserve all the ones Cpp1 has both for compatibility and to not give up a keyword
-        //  Some keywords like "delete" and "union" are not in this list because we reject them elsewhere
-        //  Cpp2 also adds a couple, notably "is" and "as"
-        static const auto keys = std::vector<std::string_view>{
-            "alignas", "alignof", "asm", "as", "auto",
-            "bool", "break",
-            "case", "catch", "char16_t", "char32_t", "char8_t", "char", "co_await", "co_return",
-            "co_yield", "concept", "const_cast", "consteval", "constexpr", "constinit", "const", "continue",
-            "decltype", "default", "double", "do", "dynamic_cast",
-            "else", "enum", "explicit", "export", "extern",
-            "float", "for", "friend",
-            "goto",
-            "if", "import", "inline", "int", "is",
-            "long",
-            "module", "mutable",
-            "namespace", "noexcept",
-            "operator",
-            "private", "protected", "public",
-            "register", "reinterpret_cast", "requires", "return",
-            "short", "signed", "sizeof", "static_assert", "static_cast", "static", "switch",
-            "template", "this", "thread_local", "throws", "throw", "try", "typedef", "typeid", "typename",
-            "unsigned", "using",
-            "virtual", "void", "volatile",
-            "wchar_t", "while"
-        };
-
-        return do_is_keyword(keys);
-    };
-
-    auto peek_is_cpp2_fundamental_type_keyword = [&]
-    {
-        static const auto keys = std::vector<std::string_view>{
-            "i8", "i16", "i32", "i64", "longdouble", "longlong", "u8", "u16", "u32", "u64", "ulong", "ulonglong", "ushort"
-        };
-
-        return do_is_keyword(keys);
-    };
-
-    auto peek_is_cpp1_multi_token_fundamental_keyword = [&]
+    //  Returns the keyword that is the whole identifier-like word starting at i, if any
+    //
+    auto peek_keyword = [&]() -> keyword_entry const*
     {
-        static const auto multi_keys = std::vector<std::string_view>{
-            "char16_t", "char32_t", "char8_t", "char", "double", "float", "int", "long", "short", "signed", "unsigned"
-        };
-        return do_is_keyword(multi_keys);
+        auto j = skip_identifier_continue(line, i);
+        return keywords.lookup( line.substr(unsafe_narrow<std::size_t>(i), unsafe_narrow<std::size_t>(j-i)) );
     };
 
     auto reset_processing_of_the_line = [&]() {
@@ -1019,7 +1331,7 @@ auto lex_line(
     ) -> bool {
         auto parts = expand_raw_string_literal(opening_seq, closing_seq, closing_strategy, part, errors, source_position(lineno, pos_to_replace + 1));
         auto new_part = parts.generate();
-        mutable_line.replace( pos_to_replace, size_to_replace, new_part );
+        replace_in_line( pos_to_replace, size_to_replace, new_part );
         i += std::ssize(new_part)-1;
 
         if (parts.is_expanded()) {
@@ -1074,23 +1386,27 @@ auto lex_line(
         //  the only thing to look for is the */ comment end
         //
         if (in_comment) {
-            switch (line[i]) {
-            //  */ comment end
-            break;case '*':
-                if (peek1 == '/') {
-                    current_comment += "*/";
-                    comments.push_back({
-                        comment::comment_kind::stream_comment,
-                        current_comment_start,
-                        source_position(lineno, i + 2),
-                        current_comment
-                        });
-                    in_comment = false;
-                    ++i;
-                }
-            break;default:
-                current_comment += line[i];
+            auto end = line.find("*/", i);
+            if (end == line.npos) {
+                break;  // the rest of the line is added to current_comment at END
+            }
+
+            //  A comment on one line is a view of the line, and only the
+            //  text of one that spans lines is joined and kept separately
+            auto text = line.substr(comment_start_here(), end+2 - comment_start_here());
+            if (current_comment_start.lineno != lineno) {
+                current_comment += text;
+                text = generated_text.store( current_comment, false );
+                current_comment.clear();
             }
+            comments.push_back({
+                comment::comment_kind::stream_comment,
+                current_comment_start,
+                source_position(lineno, __as<colno_t>(end + 2)),
+                text
+                });
+            in_comment = false;
+            i = __as<int>(end) + 1;
         }
         else if (raw_string_multiline) {
             auto end_pos = line.find(raw_string_multiline.value().closing_seq, i);
@@ -1121,10 +1437,10 @@ auto lex_line(
             i = end_pos+std::ssize(raw_string_multiline.value().closing_seq)-1;
 
             const auto& text = raw_string_multiline.value().should_interpolate ? raw_string_multiline.value().text.substr(1) : raw_string_multiline.value().text;
-            multiline_raw_strings.emplace_back(multiline_raw_string{ text, {lineno, i} });
+            multiline_raw_strings.emplace_back(multiline_raw_string{ generated_text.store(text), {lineno, i} });
 
             tokens.push_back({
-                &multiline_raw_strings.back().text[0],
+                multiline_raw_strings.back().text.data(),
                 std::ssize(multiline_raw_strings.back().text),
                 raw_string_multiline.value().start,
                 lexeme::StringLiteral
@@ -1135,6 +1451,9 @@ auto lex_line(
 
         //  Otherwise, we will be at the start of a token, a comment, or whitespace
         //
+        else if (isspace(line[i])) {
+            i = skip_whitespace(line, i) - 1;
+        }
         else {
             //G token:
             //G     identifier
@@ -1159,7 +1478,7 @@ auto lex_line(
             //G     '/=' '/'
             break;case '/':
                 if (peek1 == '*') {
-                    current_comment = "/*";
+                    current_comment.clear();
                     current_comment_start = source_position(lineno, i+1);
                     in_comment = true;
                     ++i;
@@ -1169,7 +1488,7 @@ auto lex_line(
                         comment::comment_kind::line_comment,
                         {lineno, i},
                         {lineno, __as<colno_t>(std::ssize(line))},
-                        std::string(&line[i], std::ssize(line) - i)
+                        line.substr(unsafe_narrow<std::size_t>(i))
                         });
                     in_comment = false;
                     goto END;
@@ -1325,8 +1644,8 @@ auto lex_line(
                     auto seq_pos = i + 3;
                         
                     if (auto paren_pos = line.find("(", seq_pos); paren_pos != std::string::npos) {
-                        auto opening_seq = line.substr(i, paren_pos - i + 1);
-                        auto closing_seq = ")"+line.substr(seq_pos, paren_pos-seq_pos)+"\"";
+                        auto opening_seq = std::string{line.substr(i, paren_pos - i + 1)};
+                        auto closing_seq = ")"+std::string{line.substr(seq_pos, paren_pos-seq_pos)}+"\"";
 
                         if (auto closing_pos = line.find(closing_seq, paren_pos+1); closing_pos != line.npos) {
                             if (interpolate_raw_string(
@@ -1420,7 +1739,7 @@ auto lex_line(
                 }
                 else if (peek1 == 'x' || peek1 == 'X') {
                     if (is_hexadecimal_digit(peek2)) {
-                        while (is_separator_or(is_hexadecimal_digit,peek(j))) { ++j; }
+                        j = skip_hexadecimal_digits(line, i+j) - i;
                         store(j, lexeme::HexadecimalLiteral);
                         continue;
                     }
@@ -1463,7 +1782,7 @@ auto lex_line(
                 //G
                 else if (is_digit(line[i])) {
                     auto j = 1;
-                    while (is_separator_or(is_digit,peek(j))) { ++j; }
+                    j = skip_digits(line, i+j) - i;
                     if (
                         (peek(j) != '.' || !is_digit(peek(j+1)))
                         && peek(j) != 'f'
@@ -1497,16 +1816,14 @@ auto lex_line(
                                     "a floating point literal must have at least one digit after the decimal point (can be '.0')"
                                 );
                             }
-                            while (is_separator_or(is_digit,peek(j))) {
-                                ++j;
-                            }
+                            j = skip_digits(line, i+j) - i;
                         }
 
                         // slurp the exponential form marker
                         if (peek(j) == 'e' || peek(j) == 'E') {
                             ++j;
                             if (peek(j) == '-' || peek(j) == '+') { ++j; }
-                            while (is_separator_or(is_digit,peek(j))) { ++j; }
+                            j = skip_digits(line, i+j) - i;
                         }
 
                         // TODO: This dumbly slurps the suffixes fF or
@@ -1540,8 +1857,8 @@ auto lex_line(
                         auto seq_pos = i + j;
                             
                         if (auto paren_pos = line.find("(", seq_pos); paren_pos != std::string::npos) {
-                            auto opening_seq = line.substr(i, paren_pos - i + 1);
-                            auto closing_seq = ")"+line.substr(seq_pos, paren_pos-seq_pos)+"\"";
+                            auto opening_seq = std::string{line.substr(i, paren_pos - i + 1)};
+                            auto closing_seq = ")"+std::string{line.substr(seq_pos, paren_pos-seq_pos)}+"\"";
 
                             if (auto closing_pos = line.find(closing_seq, paren_pos+1); closing_pos != line.npos) {
                                 store(closing_pos+std::ssize(closing_seq)-i, lexeme::StringLiteral);
@@ -1566,7 +1883,11 @@ auto lex_line(
                         }
                     }
                     else {
-                        while (auto len = peek_is_sc_char(j, '\"')) { j += len; }
+                        j = skip_plain_string_chars(line, i+j) - i;
+                        while (auto len = peek_is_sc_char(j, '\"')) {
+                            j += len;
+                            j = skip_plain_string_chars(line, i+j) - i;
+                        }
                         if (peek(j) != '\"') {
                             errors.emplace_back(
                                 source_position(lineno, i),
@@ -1595,7 +1916,7 @@ auto lex_line(
                                 );
                                 return {};
                             }
-                            mutable_line.replace( i, j+1, s );
+                            replace_in_line( i, j+1, s );
 
                             reset_processing_of_the_line();
                         }
@@ -1630,22 +1951,11 @@ auto lex_line(
                     }
                 }
 
-                //  Cpp1 multi-token fundamental type keyword
-                //
-                else if (auto j = peek_is_cpp1_multi_token_fundamental_keyword()) {
-                    store(j, lexeme::Cpp1MultiKeyword);
-                }
-
-                //  Cpp2 fixed-width type alias keyword
-                //
-                else if (auto j = peek_is_cpp2_fundamental_type_keyword()) {
-                    store(j, lexeme::Cpp2FixedType);
-                }
-
-                //  Other keyword
+                //  Keyword, including Cpp1 multi-token fundamental type keywords
+                //  and Cpp2 fixed-width type alias keywords
                 //
-                else if (auto j = peek_is_keyword()) {
-                    store(j, lexeme::Keyword);
+                else if (auto k = peek_keyword()) {
+                    store(std::ssize(k->text), k->type);
 
                     if (tokens.back() == "const_cast") {
                         errors.emplace_back(
@@ -1725,7 +2035,8 @@ auto lex_line(
 
 END:
     if (in_comment) {
-        current_comment += "\n";
+        current_comment += line.substr(comment_start_here());
+        current_comment += '\n';
     }
     if (raw_string_multiline && line.size() == 0) {
         raw_string_multiline.value().text += '\n';
@@ -1745,10 +2056,21 @@ END:
 
 class tokens
 {
+public:
+    //  A Cpp2 code section's tokens are a contiguous range of the token stream
+    struct section {
+        lineno_t lineno;    // the line the section starts on
+        int      first;     // index of the section's first token
+        int      last;      // index one past the section's last token
+    };
+
+private:
     std::vector<error_entry>& errors;
 
-    //  All non-comment source tokens go here, which will be parsed in the parser
-    std::map<lineno_t, std::vector<token>> grammar_map;
+    //  All non-comment source tokens go here, in one array for the whole
+    //  translation unit, which will be parsed in the parser
+    std::vector<token>   token_stream;
+    std::vector<section> sections;
 
     //  All comment source tokens go here, which are applied in the lexer
     //
@@ -1778,92 +2100,876 @@ public:
     //-----------------------------------------------------------------------
     //  lex: Tokenize the Cpp2 lines
     //
-    //  lines           tagged source lines
-    //  is_generated    is this generated code
+    //  lines                   tagged source lines
+    //  is_generated            is this generated code
+    //  parallel_min_sections   a file with at least this many Cpp2 sections
+    //                          has groups of its sections lexed in parallel
     //
+    static constexpr auto default_parallel_min_sections = 64;
+
     auto lex(
         std::vector<source_line>& lines,
-        bool                      is_generated = false
+        bool                      is_generated          = false,
+        int                       parallel_min_sections = default_parallel_min_sections
     )
         -> void
     {
-        auto in_comment           = false;
-        auto raw_string_multiline = std::optional<raw_string>();
-
         assert (std::ssize(lines) > 0);
-        auto line = std::begin(lines);
-        while (line != std::end(lines)) {
 
-            //  Skip over non-Cpp2 lines
-            if (line->cat != source_line::category::cpp2) {
-                ++line;
+        //  Find the Cpp2 sections, each a run of Cpp2 lines
+        auto ranges = std::vector<line_range>{};
+        for (auto i = 0; i < std::ssize(lines); ++i) {
+            if (lines[i].cat == source_line::category::cpp2) {
+                if (ranges.empty() || ranges.back().last < i) {
+                    ranges.push_back({i, i});
+                }
+                ranges.back().last = i+1;
+            }
+        }
+
+        auto state = lex_state{};
+        multiline_raw_strings.clear();
+
+        if (keep_line_starts) {
+            assert (!is_generated);
+            line_starts.assign(lines.size(), {});
+            line_states.clear();
+            snapshot_texts.clear();
+            growing_text = -1;
+        }
+
+        //  Lex the sections [first,last) of 'ranges' on this thread, in place
+        auto lex_here = [&](auto first, auto last) {
+            for (auto r = first; r != last; ++r) {
+                lex_section(
+                    std::span{lines}.subspan(r->first, r->last - r->first),
+                    section_lineno(*r, is_generated),
+                    state,
+                    token_stream, sections, comments, errors,
+                    [&](lineno_t lineno, auto const& entry, auto const&... snapshot) {
+                        if (keep_line_starts) {
+                            line_starts[lineno] = take_line_start(
+                                __as<int>(std::ssize(token_stream) + std::ssize(entry)),
+                                __as<int>(std::ssize(comments)),
+                                entry,
+                                snapshot...
+                            );
+                            line_starts[lineno].text = lines[lineno].text;
+                        }
+                    }
+                );
+            }
+        };
+
+        auto threads = parallel_threads();
+        if (
+            is_generated
+            || keep_line_starts
+            || std::ssize(ranges) < parallel_min_sections
+            || threads < 2
+            )
+        {
+            lex_here(ranges.begin(), ranges.end());
+            return;
+        }
+
+        //  Otherwise, split the sections into one group per thread, with
+        //  about the same number of lines each, and lex the groups after the
+        //  first in parallel into their own buffers while this thread does
+        //  the first group
+        //
+        //  Every section ordinarily starts in a clean state (not in a comment
+        //  or multiline raw string), so each group is lexed assuming that,
+        //  and then the groups are stitched in line order so the tokens,
+        //  comments, and errors are the same as lexing them all in turn
+        //
+        auto total_lines = 0;
+        for (auto const& r : ranges) {
+            total_lines += r.last - r.first;
+        }
+
+        auto group_starts = std::vector<std::vector<line_range>::iterator>{ ranges.begin() };
+        auto group_lines  = 0;
+        for (auto r = ranges.begin(); r != ranges.end(); ++r) {
+            if (group_lines >= total_lines / threads * std::ssize(group_starts)) {
+                if (r != group_starts.back()) {
+                    group_starts.push_back(r);
+                }
+            }
+            group_lines += r->last - r->first;
+        }
+        group_starts.push_back(ranges.end());
+
+        auto groups = std::vector<std::future<lexed_group>>{};
+        for (auto g = 1; g+1 < std::ssize(group_starts); ++g)
+        {
+            groups.push_back( std::async(
+                std::launch::async,
+                [&lines, is_generated, first = group_starts[g], last = group_starts[g+1]] {
+                    return lex_group(lines, is_generated, first, last);
+                }
+            ) );
+        }
+
+        lex_here(group_starts[0], group_starts[1]);
+
+        for (auto g = 0; g < std::ssize(groups); ++g)
+        {
+            auto group = groups[g].get();
+
+            //  If the group really starts in a comment or raw string, it was
+            //  lexed on the wrong assumption, so lex it again here
+            if (state.in_comment || state.raw_string_multiline) {
+                lex_here(group_starts[g+1], group_starts[g+2]);
                 continue;
             }
 
-            //  At this point, we're at the first line of a Cpp2 code section
+            //  Otherwise take it over: its lines (which lexing can rewrite),
+            //  the text generated for them, its tokens (interning their names
+            //  here, since the group's thread didn't), comments, and errors
+            std::copy(
+                group.lines.begin(), group.lines.end(),
+                lines.begin() + group_starts[g+1]->first
+            );
+            generated_text.adopt( std::move(group.text) );
+
+            auto offset = __as<int>(std::ssize(token_stream));
+            for (auto& t : group.tokens) {
+                t.set_type( t.type() );
+            }
+            token_stream.insert(token_stream.end(), group.tokens.begin(), group.tokens.end());
+            for (auto s : group.sections) {
+                s.first += offset;
+                s.last  += offset;
+                sections.push_back(s);
+            }
+            comments.insert(comments.end(), group.comments.begin(), group.comments.end());
+            errors  .insert(errors  .end(), group.errors  .begin(), group.errors  .end());
+
+            state = std::move(group.end_state);
+        }
+    }
+
+private:
+    //  The lines of a Cpp2 section, [first,last) in the source lines
+    struct line_range {
+        int first;
+        int last;
+    };
+
+    //  What a section can start in, from the end of the previous section
+    struct lex_state {
+        bool                      in_comment = false;
+        std::optional<raw_string> raw_string_multiline;
+    };
+
+    //  A group of sections lexed on another thread, with its own copy of
+    //  the lines and its own output
+    struct lexed_group {
+        std::vector<source_line> lines;
+        text_arena               text;
+        std::vector<token>       tokens;
+        std::vector<section>     sections;
+        std::vector<comment>     comments;
+        std::vector<error_entry> errors;
+        lex_state                end_state;
+    };
+
+    //  With enable_relex, lex keeps a snapshot of the lexer at the start of
+    //  each Cpp2 line, indexed by line number, for relex to restart from
+    struct line_start {
+        int  first_token   = -1;    // where the line's tokens start in token_stream
+        int  first_comment = -1;    // where its comments start in comments
+        int  state         = -1;    // in line_states, or -1 if not in a comment or raw string
+        bool independent   = false; // can't change tokens before it (see take_line_start)
+        std::string_view text;      // the line before lexing (which can rewrite it)
+    };
+
+    //  The lexer state that carries from one line to the next, which is
+    //  usually empty so it's stored separately only when it isn't
+    //
+    //  The text of a comment or raw string so far only grows from line to
+    //  line, so the snapshots taken inside one share a copy of its text in
+    //  snapshot_texts and each stores just its length (copying the text
+    //  into each snapshot would take quadratic space for a long comment,
+    //  or for an edit that opens a raw string that runs to the end)
+    struct lex_snapshot {
+        bool                      in_comment = false;
+        std::optional<raw_string> raw_string_multiline;     // without its text
+        source_position           current_comment_start;
+        int                       text      = -1;           // in snapshot_texts
+        int                       text_size = 0;
+    };
+
+    bool                      keep_line_starts = false;
+    std::vector<line_start>   line_starts;
+    std::vector<lex_snapshot> line_states;
+    std::vector<std::string>  snapshot_texts;
+    int                       growing_text = -1;            // that the next snapshot can extend
+
+    auto take_line_start(
+        int                       first_token,
+        int                       first_comment,
+        std::vector<token> const& entry,
+        lex_state const&          state,
+        std::string const&        current_comment,
+        source_position           current_comment_start
+    )
+        -> line_start
+    {
+        auto ret = line_start{};
+        ret.first_token   = first_token;
+        ret.first_comment = first_comment;
+
+        if (state.in_comment || state.raw_string_multiline) {
+            auto const& text = state.in_comment ? current_comment : state.raw_string_multiline->text;
+
+            auto snap = lex_snapshot{ state.in_comment, {}, current_comment_start };
+            if (auto const& raw = state.raw_string_multiline) {
+                snap.raw_string_multiline = raw_string{ raw->start, {}, raw->opening_seq, raw->closing_seq, raw->should_interpolate };
+            }
+            snap.text_size = __as<int>(std::ssize(text));
+
+            //  Extend the text of the previous snapshot if this is the same
+            //  comment or raw string, else start a new one
+            if (
+                growing_text >= 0
+                && line_states.back().in_comment == snap.in_comment
+                && line_states.back().current_comment_start == snap.current_comment_start
+                && line_states.back().raw_string_multiline == snap.raw_string_multiline
+                && line_states.back().text_size <= snap.text_size
+                )
+            {
+                snap.text = growing_text;
+                snapshot_texts[growing_text].append(text, snapshot_texts[growing_text].size());
+            }
+            else {
+                snap.text = growing_text = __as<int>(std::ssize(snapshot_texts));
+                snapshot_texts.push_back(text);
+            }
+
+            ret.state = __as<int>(std::ssize(line_states));
+            line_states.push_back(std::move(snap));
+        }
+        else {
+            growing_text = -1;
+        }
+
+        //  lex_line can change the tokens just before a line when it merges
+        //  a Cpp1 multi-word keyword type or an "operator?" name, or makes
+        //  the line's first identifier a literal's suffix, so the line is
+        //  independent of them only if none of those can happen
+        auto n = std::ssize(entry);
+        ret.independent =
+            n == 0
+            || (
+                entry[n-1].type() != lexeme::Cpp1MultiKeyword
+                && !is_literal(entry[n-1].type())
+                && entry[n-1] != "operator"
+                && (n < 2 || entry[n-2] != "operator")
+                );
+
+        return ret;
+    }
+
+    auto same_state(
+        line_start const&  start,
+        lex_state const&   state,
+        std::string const& current_comment,
+        source_position    current_comment_start
+    ) const
+        -> bool
+    {
+        if (start.state < 0) {
+            return !state.in_comment && !state.raw_string_multiline;
+        }
+        auto const& old  = line_states[start.state];
+        auto        text = std::string_view{snapshot_texts[old.text]}.substr(0, old.text_size);
+        if (
+            old.in_comment != state.in_comment
+            || old.raw_string_multiline.has_value() != state.raw_string_multiline.has_value()
+            )
+        {
+            return false;
+        }
+        if (auto const& raw = state.raw_string_multiline) {
+            auto const& old_raw = *old.raw_string_multiline;
+            return
+                old_raw.start == raw->start
+                && old_raw.opening_seq == raw->opening_seq
+                && old_raw.closing_seq == raw->closing_seq
+                && old_raw.should_interpolate == raw->should_interpolate
+                && text == raw->text;
+        }
+        return
+            !state.in_comment
+            || (
+                old.current_comment_start == current_comment_start
+                && text == current_comment
+                );
+    }
+
+    //  Restore the lexer state from a line's snapshot
+    auto restore_state(
+        line_start const& start,
+        lex_state&        state,
+        std::string&      current_comment,
+        source_position&  current_comment_start
+    ) const
+        -> void
+    {
+        state = {};
+        current_comment.clear();
+        current_comment_start = {};
+        if (start.state < 0) {
+            return;
+        }
+        auto const& snap = line_states[start.state];
+        auto        text = snapshot_texts[snap.text].substr(0, snap.text_size);
+        state.in_comment           = snap.in_comment;
+        state.raw_string_multiline = snap.raw_string_multiline;
+        current_comment_start      = snap.current_comment_start;
+        if (state.raw_string_multiline) {
+            state.raw_string_multiline->text = std::move(text);
+        }
+        else {
+            current_comment = std::move(text);
+        }
+    }
+
+    //  Replace v[first,last) with [from,to)
+    static auto replace_range(auto& v, int first, int last, auto from, auto to)
+        -> void
+    {
+        auto n = std::distance(from, to);
+        auto common = std::min<std::ptrdiff_t>(n, last - first);
+        std::copy(from, from + common, v.begin() + first);
+        if (n > last - first) {
+            v.insert(v.begin() + last, from + common, to);
+        }
+        else {
+            v.erase(v.begin() + first + common, v.begin() + last);
+        }
+    }
+
+    static auto section_lineno(
+        line_range const& r,
+        bool              is_generated
+    )
+        -> lineno_t
+    {
+        //  If this is generated code, use negative line numbers to
+        //  inform and assist the printer
+        return r.first - (is_generated ? 10'000 : 0);
+    }
+
+    static auto lex_group(
+        std::vector<source_line> const&                lines,
+        bool                                           is_generated,
+        std::vector<line_range>::const_iterator        first,
+        std::vector<line_range>::const_iterator        last
+    )
+        -> lexed_group
+    {
+        //  Names are interned by the thread that takes the tokens over
+        auto my_symbols = std::exchange(symbols, nullptr);
+
+        auto ret = lexed_group{};
+        auto base = first->first;
+        ret.lines.assign(lines.begin() + base, lines.begin() + std::prev(last)->last);
+        multiline_raw_strings.clear();
+
+        for (auto r = first; r != last; ++r) {
+            lex_section(
+                std::span{ret.lines}.subspan(r->first - base, r->last - r->first),
+                section_lineno(*r, is_generated),
+                ret.end_state,
+                ret.tokens, ret.sections, ret.comments, ret.errors,
+                [](auto&&...) {}
+            );
+        }
 
-            //  Create new map entry for the section starting at this line,
-            //  and populate its tokens with the tokens in this section
-            auto lineno = std::distance(std::begin(lines), line);
+        ret.text = std::exchange(generated_text, {});
+        symbols  = my_symbols;
+        return ret;
+    }
 
-            //  If this is generated code, use negative line numbers to
-            //  inform and assist the printer
-            if (is_generated) {
-                lineno -= 10'000;
+    //  Lex the next line of a section, appending to the section's tokens
+    static auto lex_section_line(
+        source_line&              line,
+        lineno_t                  lineno,
+        lex_state&                state,
+        std::string&              current_comment,
+        source_position&          current_comment_start,
+        std::vector<token>&       entry,
+        std::vector<comment>&     out_comments,
+        std::vector<error_entry>& out_errors
+    )
+        -> void
+    {
+        lex_line(
+            line.text, lineno,
+            state.in_comment, current_comment, current_comment_start,
+            entry, out_comments, out_errors,
+            state.raw_string_multiline
+        );
+
+        //  Check whether all the tokens on this line were consecutive
+        //  w/o extra whitespace (separated by 0 or 1 whitespace chars)
+        if (!entry.empty()) {
+            for (auto i = std::ssize(entry) - 1;
+                i > 0;
+                --i
+                )
+            {
+                if (entry[i-1].position().lineno != lineno) {
+                    break;
+                }
+
+                if (
+                    entry[i].position().lineno == lineno
+                    && entry[i-1].position().colno + entry[i-1].length() + 1
+                        < entry[i].position().colno
+                    )
+                {
+                    line.all_tokens_are_densely_spaced = false;
+                    break;
+                }
             }
+        }
+    }
 
-            auto& entry = grammar_map[lineno];
-            auto current_comment = std::string{};
-            auto current_comment_start = source_position{};
+    //  Lex one section's lines, appending to the given outputs
+    //  (calling before_line with the state at the start of each line)
+    static auto lex_section(
+        std::span<source_line>    lines,
+        lineno_t                  section_lineno,
+        lex_state&                state,
+        std::vector<token>&       out_tokens,
+        std::vector<section>&     out_sections,
+        std::vector<comment>&     out_comments,
+        std::vector<error_entry>& out_errors,
+        auto&&                    before_line
+    )
+        -> void
+    {
+        //  Each section is lexed on its own (lex_line looks back at the
+        //  tokens so far) and then appended to the token stream, in scratch
+        //  space that is kept since metafunctions lex many small fragments
+        static thread_local auto entry = std::vector<token>{};
+        entry.clear();
+
+        auto lineno = section_lineno;
+        auto current_comment = std::string{};
+        auto current_comment_start = source_position{};
+
+        for (auto& line : lines) {
+            before_line(lineno, entry, state, current_comment, current_comment_start);
+            lex_section_line(
+                line, lineno++, state, current_comment, current_comment_start,
+                entry, out_comments, out_errors
+            );
+        }
 
-            for (
-                ;
-                line != std::end(lines) && line->cat == source_line::category::cpp2;
-                ++line, ++lineno
+        out_sections.push_back({
+            section_lineno,
+            __as<int>(std::ssize(out_tokens)),
+            __as<int>(std::ssize(out_tokens) + std::ssize(entry))
+        });
+        out_tokens.insert(out_tokens.end(), entry.begin(), entry.end());
+    }
+
+public:
+
+    //-----------------------------------------------------------------------
+    //  enable_relex: Make lex keep a snapshot of its state at the start of
+    //  each line, so that relex can later redo just part of the file (this
+    //  also makes lex run on one thread)
+    //
+    auto enable_relex()
+        -> void
+    {
+        keep_line_starts = true;
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  relex: Tokenize again after an edit, patching the token stream and
+    //  comments in place
+    //
+    //  lines           the source lines lex was given, of which [first,last)
+    //                  have new text
+    //
+    //  This restarts from the snapshot at the first edited Cpp2 line (or
+    //  an earlier line if that line's tokens can merge with earlier ones),
+    //  and stops at the first line after the edit where the lexer is back
+    //  in the state it was in there before, since from there on the tokens
+    //  would come out the same
+    //
+    //  Returns false if the edit can't be handled this way, because relex
+    //  wasn't enabled or lines were added, removed, or changed between Cpp1
+    //  and Cpp2, and then the file needs to be lexed again from scratch.
+    //  Any parse trees of these tokens need to be rebuilt afterwards, and
+    //  new lexing errors are added to the error list
+    //
+    auto relex(
+        std::vector<source_line>& lines,
+        int                       first,
+        int                       last
+    )
+        -> bool
+    {
+        if (
+            !keep_line_starts
+            || std::ssize(lines) != std::ssize(line_starts)
+            )
+        {
+            return false;
+        }
+        assert (0 <= first && first <= last && last <= std::ssize(lines));
+        for (auto i = first; i < last; ++i) {
+            if ((lines[i].cat == source_line::category::cpp2) != (line_starts[i].first_token >= 0)) {
+                return false;
+            }
+        }
+
+        auto line = first;
+        while (line < last && line_starts[line].first_token < 0) {
+            ++line;
+        }
+        if (line == last) {
+            return true;    // no Cpp2 lines were edited
+        }
+        while (!line_starts[line].independent) {
+            --line;         // a section's first line is always independent
+        }
+
+        auto state                 = lex_state{};
+        auto current_comment       = std::string{};
+        auto current_comment_start = source_position{};
+        restore_state(line_starts[line], state, current_comment, current_comment_start);
+        growing_text = -1;
+
+        auto entry        = std::vector<token>{};
+        auto new_comments = std::vector<comment>{};
+        auto new_starts   = std::vector<line_start>{};
+        multiline_raw_strings.clear();
+
+        //  Relex one section at a time, since the edit can change what the
+        //  next section starts in (e.g., by leaving a /* comment open)
+        while (true)
+        {
+            auto sec = std::prev(std::upper_bound(
+                sections.begin(), sections.end(), line,
+                [](int l, section const& s) { return l < s.lineno; }
+            ));
+            auto section_end = line;
+            while (section_end < std::ssize(lines) && line_starts[section_end].first_token >= 0) {
+                ++section_end;
+            }
+
+            auto old_first_token   = line_starts[line].first_token;
+            auto old_first_comment = line_starts[line].first_comment;
+
+            //  Give lex_line the two tokens before, which it may look at
+            //  (the line is independent of them, so it won't change them)
+            entry.assign(
+                token_stream.begin() + std::max(sec->first, old_first_token - 2),
+                token_stream.begin() + old_first_token
+            );
+            auto seeded = std::ssize(entry);
+            new_comments.clear();
+            new_starts.clear();
+
+            auto converged = false;
+            auto l = line;
+            for (; l < section_end; ++l)
+            {
+                auto start = take_line_start(
+                    __as<int>(std::ssize(entry) - seeded),
+                    __as<int>(std::ssize(new_comments)),
+                    entry, state, current_comment, current_comment_start
+                );
+                if (
+                    l >= last
+                    && start.independent
+                    && line_starts[l].independent
+                    && same_state(line_starts[l], state, current_comment, current_comment_start)
+                    )
+                {
+                    converged = true;
+                    break;
+                }
+                if (l < first || last <= l) {
+                    lines[l].text = line_starts[l].text;
+                }
+                start.text = lines[l].text;
+                new_starts.push_back(start);
+
+                lines[l].all_tokens_are_densely_spaced = true;
+                lex_section_line(
+                    lines[l], l, state, current_comment, current_comment_start,
+                    entry, new_comments, errors
+                );
+            }
+
+            //  Replace the old tokens and comments of lines [line,l)
+            auto next_comment = __as<int>(std::ssize(comments));
+            for (auto i = l; i < std::ssize(lines); ++i) {
+                if (line_starts[i].first_token >= 0) {
+                    next_comment = line_starts[i].first_comment;
+                    break;
+                }
+            }
+            auto old_last_token   = converged ? line_starts[l].first_token : sec->last;
+            auto old_last_comment = next_comment;
+
+            auto token_delta   = __as<int>(std::ssize(entry) - seeded - (old_last_token - old_first_token));
+            auto comment_delta = __as<int>(std::ssize(new_comments) - (old_last_comment - old_first_comment));
+
+            replace_range(token_stream, old_first_token, old_last_token, entry.begin() + seeded, entry.end());
+            replace_range(comments, old_first_comment, old_last_comment, new_comments.begin(), new_comments.end());
+
+            sec->last += token_delta;
+            for (auto s = std::next(sec); s != sections.end(); ++s) {
+                s->first += token_delta;
+                s->last  += token_delta;
+            }
+            for (auto i = line; i < l; ++i) {
+                line_starts[i] = new_starts[i - line];
+                line_starts[i].first_token   += old_first_token;
+                line_starts[i].first_comment += old_first_comment;
+            }
+            for (auto i = l; i < std::ssize(lines); ++i) {
+                if (line_starts[i].first_token >= 0) {
+                    line_starts[i].first_token   += token_delta;
+                    line_starts[i].first_comment += comment_delta;
+                }
+            }
+
+            if (converged) {
+                break;
+            }
+
+            //  Otherwise go on to the next section, unless it starts in the
+            //  same state as before (each section starts a new comment text)
+            line = section_end;
+            while (line < std::ssize(lines) && line_starts[line].first_token < 0) {
+                ++line;
+            }
+            current_comment.clear();
+            current_comment_start = {};
+            if (
+                line == std::ssize(lines)
+                || same_state(line_starts[line], state, current_comment, current_comment_start)
                 )
             {
-                lex_line(
-                    line->text, lineno,
-                    in_comment, current_comment, current_comment_start,
-                    entry, comments, errors,
-                    raw_string_multiline
+                break;
+            }
+        }
+
+        return true;
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  fused_lexer: Lexes the Cpp2 lines while source::load finds them, and
+    //  tells it where each definition ends, so Cpp2 text is scanned once
+    //  instead of once to find the definitions and again to lex them
+    //
+    //  Pass it to source::load as the definition finder, then call finish()
+    //  instead of lex(). The end of a definition comes from the tokens, so
+    //  unlike process_cpp2_line this isn't fooled by braces, semicolons, or
+    //  quotes in character literals and raw string literals
+    //
+    class fused_lexer
+    {
+        tokens&                  toks;
+        lex_state                state;
+        std::vector<token>       entry;
+        std::string              current_comment;
+        source_position          current_comment_start;
+        std::vector<error_entry> lex_errors;        // reported after loading's
+        int                      next_line   = 0;   // the first line not yet seen
+        int                      section_end = -1;  // one past the section so far
+        lineno_t                 section_lineno = 0;
+
+        auto end_section()
+            -> void
+        {
+            if (section_end >= 0) {
+                toks.sections.push_back({
+                    section_lineno,
+                    __as<int>(std::ssize(toks.token_stream)),
+                    __as<int>(std::ssize(toks.token_stream) + std::ssize(entry))
+                });
+                toks.token_stream.insert(toks.token_stream.end(), entry.begin(), entry.end());
+                entry.clear();
+                section_end = -1;
+            }
+        }
+
+    public:
+        fused_lexer(tokens& t)
+            : toks{t}
+        { }
+
+        //  Lex the Cpp2 lines added since the last call, of which the last
+        //  is the latest line of a definition, and return whether that line
+        //  ends the definition
+        auto operator()(
+            std::vector<source_line>& lines,
+            bool&                     in_comment,
+            braces_tracker&           braces,
+            std::vector<error_entry>& errors
+        )
+            -> bool
+        {
+            auto lineno         = lineno_t(std::ssize(lines) - 1);
+            auto first_token    = std::ssize(entry);
+            auto first_comment  = std::ssize(toks.comments);
+
+            for (auto i = next_line; i <= lineno; ++i)
+            {
+                if (lines[i].cat != source_line::category::cpp2) {
+                    continue;
+                }
+                if (i != section_end) {
+                    end_section();
+                    section_lineno = i;
+                    current_comment.clear();
+                    current_comment_start = {};
+                }
+                first_token = std::ssize(entry);
+                lex_section_line(
+                    lines[i], i, state, current_comment, current_comment_start,
+                    entry, toks.comments, lex_errors
                 );
+                section_end = i+1;
+            }
+            next_line = lineno+1;
+            in_comment = state.in_comment;
+
+            //  Now go through this line's braces, semicolons, and comment
+            //  starts in order, the way process_cpp2_line goes through its
+            //  characters (columns here are 0-based)
+            auto stream_comment_starts = std::vector<colno_t>{};
+            auto line_comment_start    = std::optional<colno_t>{};
+            for (auto c = first_comment; c < std::ssize(toks.comments); ++c) {
+                auto const& com = toks.comments[c];
+                if (com.start.lineno == lineno) {
+                    if (com.kind == comment::comment_kind::line_comment) {
+                        line_comment_start = com.start.colno;
+                    }
+                    else {
+                        stream_comment_starts.push_back(com.start.colno - 1);
+                    }
+                }
+            }
+            if (state.in_comment && current_comment_start.lineno == lineno) {
+                stream_comment_starts.push_back(current_comment_start.colno - 1);
+            }
 
-                //  Check whether all the tokens on this line were consecutive
-                //  w/o extra whitespace (separated by 0 or 1 whitespace chars)
-                if (!entry.empty()) {
-                    for (auto i = std::ssize(entry) - 1;
-                        i > 0;
-                        --i
-                        )
-                    {
-                        if (entry[i-1].position().lineno != lineno) {
-                            break;
-                        }
+            auto found_end   = false;
+            auto next_stream = stream_comment_starts.begin();
+            auto stream_comments_before = [&](colno_t col) {
+                for (; next_stream != stream_comment_starts.end() && *next_stream < col; ++next_stream) {
+                    if (found_end) {
+                        errors.emplace_back(
+                            source_position(lineno, *next_stream + 1),
+                            std::string("alpha limitation:"
+                                " after the closing ; or } of a definition, the rest"
+                                " of the line cannot begin a /*...*/ comment")
+                        );
+                    }
+                }
+            };
 
-                        if (
-                            entry[i].position().lineno == lineno
-                            && entry[i-1].position().colno + entry[i-1].length() + 1
-                                < entry[i].position().colno
-                            )
-                        {
-                            line->all_tokens_are_densely_spaced = false;
-                            break;
-                        }
+            for (auto t = first_token; t < std::ssize(entry); ++t)
+            {
+                if (entry[t].position().lineno != lineno) {
+                    continue;
+                }
+                auto col = entry[t].position().colno - 1;
+                stream_comments_before(col);
+
+                switch (entry[t].type()) {
+                break;case lexeme::LeftBrace:
+                    braces.found_open_brace(lineno);
+
+                break;case lexeme::RightBrace:
+                    braces.found_close_brace( source_position(lineno, col) );
+                    if (braces.current_depth() < 1) {
+                        found_end = true;
                     }
+
+                break;case lexeme::Semicolon:
+                    if (braces.current_depth() < 1) { found_end = true; }
+
+                break;default: ;
                 }
             }
+            stream_comments_before( line_comment_start.value_or(std::numeric_limits<colno_t>::max()) );
+
+            //  As in process_cpp2_line, a // comment means the definition
+            //  continues on the next line
+            return found_end && !line_comment_start;
+        }
+
+        //  After loading, finish the last section and report lexing errors
+        auto finish()
+            -> void
+        {
+            end_section();
+            toks.errors.insert(toks.errors.end(), lex_errors.begin(), lex_errors.end());
+            lex_errors.clear();
         }
+    };
+
+    auto fused()
+        -> fused_lexer
+    {
+        return fused_lexer{*this};
     }
 
 
     //-----------------------------------------------------------------------
-    //  get_map: Access the token map
+    //  intern_names: Intern the names of tokens made on a thread with no
+    //  symbol table (see lex_group), once this thread takes them over
     //
-    auto get_map() const
-        -> auto const&
+    auto intern_names()
+        -> void
+    {
+        for (auto& t : token_stream) {
+            t.set_type( t.type() );
+        }
+        for (auto& t : generated_tokens) {
+            t.set_type( t.type() );
+        }
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  get_sections: Access the Cpp2 code sections, in line order
+    //
+    auto get_sections() const
+        -> std::vector<section> const&
+    {
+        return sections;
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  get_tokens: Access a section's tokens
+    //
+    auto get_tokens(section const& s) const
+        -> std::span<token const>
     {
-        return grammar_map;
+        assert(0 <= s.first && s.first <= s.last && s.last <= std::ssize(token_stream));
+        return std::span{token_stream}.subspan(
+            unsafe_narrow<std::size_t>(s.first),
+            unsafe_narrow<std::size_t>(s.last - s.first)
+        );
     }
 
 
@@ -1908,10 +3014,10 @@ public:
     auto debug_print(std::ostream& o) const
         -> void
     {
-        for (auto const& [lineno, entry] : grammar_map) {
+        for (auto const& section : sections) {
 
-            o << "--- Section starting at line " << lineno << "\n";
-            for (auto const& token : entry) {
+            o << "--- Section starting at line " << section.lineno << "\n";
+            for (auto const& token : get_tokens(section)) {
                 o << "    " << token << " (" << token.position().lineno
                     << "," << token.position().colno << ") "
                     << __as<std::string>(token.type()) << "\n";
@@ -1944,7 +3050,23 @@ public:
 
 };
 
-static auto generated_lexers = std::deque<tokens>{};
+static thread_local auto generated_lexers = std::deque<tokens>{};
+
+
+//-----------------------------------------------------------------------
+//  reset_generated_storage: Discard this thread's generated text, lines,
+//  lexers, and symbols, once no tokens that could refer to them are still
+//  in use (e.g., after translating each file)
+//
+auto reset_generated_storage()
+    -> void
+{
+    generated_lexers.clear();
+    this_thread_symbols.clear();
+    multiline_raw_strings.clear();
+    generated_lines.clear();
+    generated_text.clear();
+}
 
 }
 
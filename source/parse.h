@@ -26,8 +26,6 @@
 
 namespace cpp2 {
 
-auto violates_lifetime_safety = false;
-
 //-----------------------------------------------------------------------
 //  Operator categorization
 //
@@ -99,6 +97,150 @@ auto is_assignment_operator(lexeme l)
 }
 
 
+//-----------------------------------------------------------------------
+//
+//  Parse tree node storage
+//
+//-----------------------------------------------------------------------
+//
+//  A parse tree has a node for every level of every expression, so nodes
+//  are not allocated one by one: make_node places each node in the next
+//  free bytes of this thread's node_arena, and node_ptr owns it like a
+//  unique_ptr except that destroying the node doesn't free its memory.
+//  Once no nodes are left (i.e., when a translation unit's parse tree has
+//  been destroyed), the arena releases all of it at once, keeping the
+//  first block for reuse
+//
+//  So a node must be destroyed on the thread that made it
+//
+class node_arena
+{
+    static constexpr auto block_size = std::size_t{64 * 1024};
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;   // each block_size
+    std::vector<std::unique_ptr<std::byte[]>> large;    // nodes too big to share a block
+    std::byte*                                next  = {};
+    std::size_t                               left  = 0;
+    std::size_t                               alive = 0;
+
+public:
+    struct statistics {
+        std::int64_t nodes  = 0;    // made since the last release
+        std::int64_t bytes  = 0;    // that they use
+        std::int64_t blocks = 0;    // heap allocations holding them
+    };
+
+private:
+    statistics stats;
+
+public:
+    auto allocate(
+        std::size_t size,
+        std::size_t align
+    )
+        -> void*
+    {
+        assert (align <= alignof(std::max_align_t));
+        ++stats.nodes;
+        stats.bytes += __as<std::int64_t>(size);
+
+        if (size > block_size / 4) {
+            return large.emplace_back( std::make_unique<std::byte[]>(size) ).get();
+        }
+
+        auto pad = (align - reinterpret_cast<std::uintptr_t>(next) % align) % align;
+        if (pad + size > left) {
+            next = blocks.emplace_back( std::make_unique<std::byte[]>(block_size) ).get();
+            left = block_size;
+            pad  = 0;
+        }
+        auto ret = next + pad;
+        next += pad + size;
+        left -= pad + size;
+        return ret;
+    }
+
+    auto made()
+        -> void
+    {
+        ++alive;
+    }
+
+    auto destroyed()
+        -> void
+    {
+        assert (alive > 0);
+        if (--alive == 0) {
+            release();
+        }
+    }
+
+    auto get_statistics() const
+        -> statistics
+    {
+        auto ret = stats;
+        ret.blocks = __as<std::int64_t>(blocks.size() + large.size());
+        return ret;
+    }
+
+    //  Take over another arena's nodes (e.g., ones made on another thread),
+    //  which keep their addresses, so that they are destroyed as this
+    //  arena's own
+    auto adopt(node_arena&& other)
+        -> void
+    {
+        auto take = [](auto& to, auto& from) {
+            to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+            from.clear();
+        };
+        take(blocks, other.blocks);
+        take(large,  other.large);
+        alive        += std::exchange(other.alive, 0);
+        stats.nodes  += other.stats.nodes;
+        stats.bytes  += other.stats.bytes;
+        other.next  = {};
+        other.left  = 0;
+        other.stats = {};
+    }
+
+private:
+    auto release()
+        -> void
+    {
+        large.clear();
+        blocks.resize( std::min(blocks.size(), std::size_t{1}) );
+        next  = blocks.empty() ? nullptr : blocks.front().get();
+        left  = blocks.empty() ? 0       : block_size;
+        stats = {};
+    }
+};
+
+static thread_local auto parse_nodes = node_arena{};
+
+struct node_deleter
+{
+    template<typename T>
+    auto operator()(T* p) const
+        -> void
+    {
+        std::destroy_at(p);
+        parse_nodes.destroyed();
+    }
+};
+
+template<typename T>
+using node_ptr = std::unique_ptr<T, node_deleter>;
+
+template<typename T>
+auto make_node(auto&&... args)
+    -> node_ptr<T>
+{
+    auto p = new (parse_nodes.allocate(sizeof(T), alignof(T))) T(CPP2_FORWARD(args)...);
+    parse_nodes.made();
+    return node_ptr<T>{p};
+}
+
+
 //-----------------------------------------------------------------------
 //
 //  Parse tree node types
@@ -137,11 +279,11 @@ struct primary_expression_node
     std::variant<
         std::monostate,
         token const*,
-        std::unique_ptr<expression_list_node>,
-        std::unique_ptr<id_expression_node>,
-        std::unique_ptr<declaration_node>,
-        std::unique_ptr<inspect_expression_node>,
-        std::unique_ptr<literal_node>
+        node_ptr<expression_list_node>,
+        node_ptr<id_expression_node>,
+        node_ptr<declaration_node>,
+        node_ptr<inspect_expression_node>,
+        node_ptr<literal_node>
     > expr;
 
     //  API
@@ -225,7 +367,7 @@ struct postfix_expression_node;
 struct prefix_expression_node
 {
     std::vector<token const*> ops;
-    std::unique_ptr<postfix_expression_node> expr;
+    node_ptr<postfix_expression_node> expr;
 
     //  API
     //
@@ -263,18 +405,91 @@ struct prefix_expression_node
 };
 
 
-template<
-    String   Name,
-    typename Term
->
+//  The binary operators' precedence levels, from tightest to loosest
+//
+enum class precedence_level {
+    multiplicative, additive, shift, compare, relational, equality,
+    bit_and, bit_xor, bit_or, logical_and, logical_or, assignment
+};
+auto to_string_view(precedence_level level) -> std::string_view {
+    switch (level) {
+    break;case precedence_level::multiplicative: return "multiplicative";
+    break;case precedence_level::additive      : return "additive";
+    break;case precedence_level::shift         : return "shift";
+    break;case precedence_level::compare       : return "compare";
+    break;case precedence_level::relational    : return "relational";
+    break;case precedence_level::equality      : return "equality";
+    break;case precedence_level::bit_and       : return "bit-and";
+    break;case precedence_level::bit_xor       : return "bit-xor";
+    break;case precedence_level::bit_or        : return "bit-or";
+    break;case precedence_level::logical_and   : return "logical-and";
+    break;case precedence_level::logical_or    : return "logical-or";
+    break;case precedence_level::assignment    : return "assignment";
+    break;default                              : return "INVALID precedence_level";
+    }
+}
+
+
+struct binary_expression_node;
+struct is_as_expression_node;
+
+//  An operand of a binary operator is usually just an is-as-expression,
+//  else an expression using tighter-binding binary operators. Levels that
+//  have no operators of their own get no node, so a plain identifier is
+//  not a chain of a dozen single-child nodes
+//
+struct binary_operand
+{
+    //  Exactly one of these is set (or neither, if parsing failed)
+    node_ptr<binary_expression_node> binary;
+    node_ptr<is_as_expression_node>  leaf;
+
+    explicit operator bool() const
+    {
+        return binary || leaf;
+    }
+
+    //  API
+    //
+    auto is_identifier() const
+        -> bool;
+
+    auto is_id_expression() const
+        -> bool;
+
+    auto is_expression_list() const
+        -> bool;
+
+    auto get_expression_list() const
+        -> expression_list_node const*;
+
+    auto is_literal() const
+        -> bool;
+
+    auto get_postfix_expression_node() const
+        -> postfix_expression_node *;
+
+    auto is_result_a_temporary_variable() const -> bool;
+
+    auto to_string() const
+        -> std::string;
+
+    //  Internals
+    //
+    auto position() const -> source_position;
+    auto visit(auto& v, int depth) -> void;
+};
+
+
 struct binary_expression_node
 {
-    std::unique_ptr<Term> expr;
+    precedence_level level = {};
+    binary_operand   expr;
 
     struct term
     {
-        token const* op;
-        std::unique_ptr<Term> expr;
+        token const*   op;
+        binary_operand expr;
     };
     std::vector<term> terms;
 
@@ -283,26 +498,26 @@ struct binary_expression_node
     auto is_identifier() const
         -> bool
     {
-        return terms.empty() && expr->is_identifier();
+        return terms.empty() && expr.is_identifier();
     }
 
     auto is_id_expression() const
         -> bool
     {
-        return terms.empty() && expr->is_id_expression();
+        return terms.empty() && expr.is_id_expression();
     }
 
     auto is_expression_list() const
         -> bool
     {
-        return terms.empty() && expr->is_expression_list();
+        return terms.empty() && expr.is_expression_list();
     }
 
     auto get_expression_list() const
         -> expression_list_node const*
     {
         if (is_expression_list()) {
-            return expr->get_expression_list();
+            return expr.get_expression_list();
         }
         return {};
     }
@@ -310,7 +525,7 @@ struct binary_expression_node
     auto is_literal() const
         -> bool
     {
-        return terms.empty() && expr->is_literal();
+        return terms.empty() && expr.is_literal();
     }
 
     //  Get left-hand postfix-expression
@@ -318,7 +533,7 @@ struct binary_expression_node
         -> postfix_expression_node *
     {
         assert(expr);
-        return expr->get_postfix_expression_node();
+        return expr.get_postfix_expression_node();
     }
 
     //  Get first right-hand postfix-expression, if there is one
@@ -327,7 +542,7 @@ struct binary_expression_node
     {
         if (!terms.empty()) {
             assert(terms.front().expr);
-            return terms.front().expr->get_postfix_expression_node();
+            return terms.front().expr.get_postfix_expression_node();
         }
         //  else
         return {};
@@ -336,7 +551,7 @@ struct binary_expression_node
     //  "Simple" means binary (size>0) and not chained (size<2)
     struct get_lhs_rhs_if_simple_binary_expression_with_ret {
         postfix_expression_node* lhs;
-        Term*                    rhs;
+        binary_operand const*    rhs;
     };
     auto get_lhs_rhs_if_simple_binary_expression_with(lexeme op) const
         -> get_lhs_rhs_if_simple_binary_expression_with_ret
@@ -348,7 +563,7 @@ struct binary_expression_node
         {
             return {
                 get_postfix_expression_node(),
-                terms.front().expr.get()
+                &terms.front().expr
             };
         }
         //  Else
@@ -356,16 +571,15 @@ struct binary_expression_node
     }
 
     auto is_result_a_temporary_variable() const -> bool {
-        if constexpr (std::string_view(Name.value) == "assignment") {
+        if (
+            level == precedence_level::assignment
+            || terms.empty()
+            )
+        {
             assert(expr);
-            return expr->is_result_a_temporary_variable();
+            return expr.is_result_a_temporary_variable();
         } else {
-            if (terms.empty()) {
-                assert(expr);
-                return expr->is_result_a_temporary_variable();
-            } else {
-                return true;
-            }
+            return true;
         }
     }
 
@@ -373,12 +587,12 @@ struct binary_expression_node
         -> std::string
     {
         assert (expr);
-        auto ret = expr->to_string();
+        auto ret = expr.to_string();
         for (auto const& x : terms) {
             assert (x.op);
             ret += " " + x.op->to_string(true);
             assert (x.expr);
-            ret += " " + x.expr->to_string();
+            ret += " " + x.expr.to_string();
         }
         return ret;
     }
@@ -389,7 +603,7 @@ struct binary_expression_node
         -> source_position
     {
         assert (expr);
-        return expr->position();
+        return expr.position();
     }
 
     auto visit(auto& v, int depth)
@@ -397,43 +611,34 @@ struct binary_expression_node
     {
         v.start(*this, depth);
         assert (expr);
-        expr->visit(v, depth+1);
-        for (auto const& x : terms) {
+        expr.visit(v, depth+1);
+        for (auto& x : terms) {
             assert (x.op);
             v.start(*x.op, depth+1);
             assert (x.expr);
-            x.expr->visit(v, depth+1);
+            x.expr.visit(v, depth+1);
         }
         v.end(*this, depth);
     }
 };
 
 
-struct is_as_expression_node;
-
-using multiplicative_expression_node = binary_expression_node< "multiplicative" , is_as_expression_node          >;
-using additive_expression_node       = binary_expression_node< "additive"       , multiplicative_expression_node >;
-using shift_expression_node          = binary_expression_node< "shift"          , additive_expression_node       >;
-using compare_expression_node        = binary_expression_node< "compare"        , shift_expression_node          >;
-using relational_expression_node     = binary_expression_node< "relational"     , compare_expression_node        >;
-using equality_expression_node       = binary_expression_node< "equality"       , relational_expression_node     >;
-using bit_and_expression_node        = binary_expression_node< "bit-and"        , equality_expression_node       >;
-using bit_xor_expression_node        = binary_expression_node< "bit-xor"        , bit_and_expression_node        >;
-using bit_or_expression_node         = binary_expression_node< "bit-or"         , bit_xor_expression_node        >;
-using logical_and_expression_node    = binary_expression_node< "logical-and"    , bit_or_expression_node         >;
-using logical_or_expression_node     = binary_expression_node< "logical-or"     , logical_and_expression_node    >;
-using assignment_expression_node     = binary_expression_node< "assignment"     , logical_or_expression_node     >;
+//  The levels that other productions name (e.g., a condition is a
+//  logical-or-expression) always get a node, even with no operators
+//
+using logical_or_expression_node = binary_expression_node;
+using assignment_expression_node = binary_expression_node;
 
 
 struct assignment_expression_lhs_rhs {
-    postfix_expression_node*    lhs;
-    logical_or_expression_node* rhs;
+    postfix_expression_node* lhs;
+    binary_operand const*    rhs;
 };
 
 
 struct expression_node
 {
-    std::unique_ptr<assignment_expression_node> expr;
+    node_ptr<assignment_expression_node> expr;
 
     // API
     //
@@ -531,7 +736,7 @@ struct expression_list_node
 
     struct term {
         passing_style                    pass = {};
-        std::unique_ptr<expression_node> expr;
+        node_ptr<expression_node> expr;
 
         auto visit(auto& v, int depth) -> void
         {
@@ -598,7 +803,7 @@ auto primary_expression_node::is_literal() const
 
 struct expression_statement_node
 {
-    std::unique_ptr<expression_node> expr;
+    node_ptr<expression_node> expr;
     bool has_semicolon = false;
 
     //  API
@@ -656,17 +861,17 @@ struct capture_group {
 
 struct postfix_expression_node
 {
-    std::unique_ptr<primary_expression_node> expr;
+    node_ptr<primary_expression_node> expr;
 
     struct term
     {
         token const* op;
 
         //  This is used if *op is . - can be null
-        std::unique_ptr<id_expression_node> id_expr = {};
+        node_ptr<id_expression_node> id_expr = {};
 
         //  These are used if *op is [ or ( - can be null
-        std::unique_ptr<expression_list_node> expr_list = {};
+        node_ptr<expression_list_node> expr_list = {};
         token const* op_close = {};
     };
     std::vector<term> ops;
@@ -871,8 +1076,8 @@ struct unqualified_id_node
         source_position comma;
         std::variant<
             std::monostate,
-            std::unique_ptr<expression_node>,
-            std::unique_ptr<type_id_node>
+            node_ptr<expression_node>,
+            node_ptr<type_id_node>
         > arg;
     };
     std::vector<term> template_args;
@@ -934,7 +1139,7 @@ struct qualified_id_node
 {
     struct term {
         token const* scope_op;
-        std::unique_ptr<unqualified_id_node> id = {};
+        node_ptr<unqualified_id_node> id = {};
 
         term( token const* o ) : scope_op{o} { }
     };
@@ -1021,8 +1226,8 @@ struct type_id_node
     enum active { empty=0, qualified, unqualified, keyword };
     std::variant<
         std::monostate,
-        std::unique_ptr<qualified_id_node>,
-        std::unique_ptr<unqualified_id_node>,
+        node_ptr<qualified_id_node>,
+        node_ptr<unqualified_id_node>,
         token const*
     > id;
 
@@ -1140,17 +1345,17 @@ auto unqualified_id_node::to_string() const
 
 struct is_as_expression_node
 {
-    std::unique_ptr<prefix_expression_node> expr;
+    node_ptr<prefix_expression_node> expr;
 
     struct term
     {
         token const* op = {};
 
         //  This is used if *op is a type - can be null
-        std::unique_ptr<type_id_node> type = {};
+        node_ptr<type_id_node> type = {};
 
         //  This is used if *op is an expression - can be null
-        std::unique_ptr<expression_node> expr = {};
+        node_ptr<expression_node> expr = {};
     };
     std::vector<term> ops;
 
@@ -1253,6 +1458,80 @@ struct is_as_expression_node
 };
 
 
+auto binary_operand::is_identifier() const
+    -> bool
+{
+    assert (*this);
+    return binary ? binary->is_identifier() : leaf->is_identifier();
+}
+
+auto binary_operand::is_id_expression() const
+    -> bool
+{
+    assert (*this);
+    return binary ? binary->is_id_expression() : leaf->is_id_expression();
+}
+
+auto binary_operand::is_expression_list() const
+    -> bool
+{
+    assert (*this);
+    return binary ? binary->is_expression_list() : leaf->is_expression_list();
+}
+
+auto binary_operand::get_expression_list() const
+    -> expression_list_node const*
+{
+    assert (*this);
+    return binary ? binary->get_expression_list() : leaf->get_expression_list();
+}
+
+auto binary_operand::is_literal() const
+    -> bool
+{
+    assert (*this);
+    return binary ? binary->is_literal() : leaf->is_literal();
+}
+
+auto binary_operand::get_postfix_expression_node() const
+    -> postfix_expression_node *
+{
+    assert (*this);
+    return binary ? binary->get_postfix_expression_node() : leaf->get_postfix_expression_node();
+}
+
+auto binary_operand::is_result_a_temporary_variable() const -> bool {
+    assert (*this);
+    return binary ? binary->is_result_a_temporary_variable() : leaf->is_result_a_temporary_variable();
+}
+
+auto binary_operand::to_string() const
+    -> std::string
+{
+    assert (*this);
+    return binary ? binary->to_string() : leaf->to_string();
+}
+
+auto binary_operand::position() const
+    -> source_position
+{
+    assert (*this);
+    return binary ? binary->position() : leaf->position();
+}
+
+auto binary_operand::visit(auto& v, int depth)
+    -> void
+{
+    assert (*this);
+    if (binary) {
+        binary->visit(v, depth);
+    }
+    else {
+        leaf->visit(v, depth);
+    }
+}
+
+
 struct id_expression_node
 {
     source_position pos;
@@ -1260,8 +1539,8 @@ struct id_expression_node
     enum active { empty=0, qualified, unqualified };
     std::variant<
         std::monostate,
-        std::unique_ptr<qualified_id_node>,
-        std::unique_ptr<unqualified_id_node>
+        node_ptr<qualified_id_node>,
+        node_ptr<unqualified_id_node>
     > id;
 
     auto template_args_count()
@@ -1395,7 +1674,7 @@ struct compound_statement_node
 {
     source_position open_brace;
     source_position close_brace;
-    std::vector<std::unique_ptr<statement_node>> statements;
+    std::vector<node_ptr<statement_node>> statements;
 
     colno_t body_indent = 0;
 
@@ -1418,9 +1697,9 @@ struct selection_statement_node
     bool                                        is_constexpr = false;
     token const*                                identifier   = {};
     source_position                             else_pos;
-    std::unique_ptr<logical_or_expression_node> expression;
-    std::unique_ptr<compound_statement_node>    true_branch;
-    std::unique_ptr<compound_statement_node>    false_branch;
+    node_ptr<logical_or_expression_node> expression;
+    node_ptr<compound_statement_node>    true_branch;
+    node_ptr<compound_statement_node>    false_branch;
     bool                                        has_source_false_branch = false;
 
     auto position() const
@@ -1454,12 +1733,12 @@ struct iteration_statement_node
 {
     token const*                                label      = {};
     token const*                                identifier = {};
-    std::unique_ptr<assignment_expression_node> next_expression;    // if used, else null
-    std::unique_ptr<logical_or_expression_node> condition;          // used for "do" and "while", else null
-    std::unique_ptr<compound_statement_node>    statements;         // used for "do" and "while", else null
-    std::unique_ptr<expression_node>            range;              // used for "for", else null
-    std::unique_ptr<parameter_declaration_node> parameter;          // used for "for", else null
-    std::unique_ptr<statement_node>             body;               // used for "for", else null
+    node_ptr<assignment_expression_node> next_expression;    // if used, else null
+    node_ptr<logical_or_expression_node> condition;          // used for "do" and "while", else null
+    node_ptr<compound_statement_node>    statements;         // used for "do" and "while", else null
+    node_ptr<expression_node>            range;              // used for "for", else null
+    node_ptr<parameter_declaration_node> parameter;          // used for "for", else null
+    node_ptr<statement_node>             body;               // used for "for", else null
     bool                                        for_with_in = false;// used for "for," says whether loop variable is 'in'
 
     auto position() const
@@ -1480,7 +1759,7 @@ struct iteration_statement_node
 struct return_statement_node
 {
     token const*                     identifier = {};
-    std::unique_ptr<expression_node> expression;
+    node_ptr<expression_node> expression;
 
     auto position() const
         -> source_position
@@ -1503,15 +1782,15 @@ struct return_statement_node
 
 struct alternative_node
 {
-    std::unique_ptr<unqualified_id_node> name;
+    node_ptr<unqualified_id_node> name;
     token const*                         is_as_keyword = {};
 
     //  One of these will be used
-    std::unique_ptr<type_id_node>            type_id;
-    std::unique_ptr<postfix_expression_node> value;
+    node_ptr<type_id_node>            type_id;
+    node_ptr<postfix_expression_node> value;
 
     source_position                      equal_sign;
-    std::unique_ptr<statement_node>      statement;
+    node_ptr<statement_node>      statement;
 
     auto position() const
         -> source_position
@@ -1529,12 +1808,12 @@ struct inspect_expression_node
 {
     bool                                     is_constexpr = false;
     token const*                             identifier   = {};
-    std::unique_ptr<expression_node>         expression;
-    std::unique_ptr<type_id_node>            result_type;
+    node_ptr<expression_node>         expression;
+    node_ptr<type_id_node>            result_type;
     source_position                          open_brace;
     source_position                          close_brace;
 
-    std::vector<std::unique_ptr<alternative_node>> alternatives;
+    std::vector<node_ptr<alternative_node>> alternatives;
 
     auto position() const
         -> source_position
@@ -1570,8 +1849,8 @@ struct contract_node
 
     source_position                             open_bracket;
     token const*                                kind = {};
-    std::unique_ptr<id_expression_node>         group;
-    std::unique_ptr<logical_or_expression_node> condition;
+    node_ptr<id_expression_node>         group;
+    node_ptr<logical_or_expression_node> condition;
     token const*                                message = {};
 
     contract_node( source_position pos )
@@ -1635,7 +1914,7 @@ struct parameter_declaration_list_node;
 
 struct statement_node
 {
-    std::unique_ptr<parameter_declaration_list_node> parameters;
+    node_ptr<parameter_declaration_list_node> parameters;
     compound_statement_node* compound_parent = nullptr;
 
     statement_node(compound_statement_node* compound_parent_ = nullptr)
@@ -1644,15 +1923,15 @@ struct statement_node
 
     enum active { expression=0, compound, selection, declaration, return_, iteration, contract, inspect, jump };
     std::variant<
-        std::unique_ptr<expression_statement_node>,
-        std::unique_ptr<compound_statement_node>,
-        std::unique_ptr<selection_statement_node>,
-        std::unique_ptr<declaration_node>,
-        std::unique_ptr<return_statement_node>,
-        std::unique_ptr<iteration_statement_node>,
-        std::unique_ptr<contract_node>,
-        std::unique_ptr<inspect_expression_node>,
-        std::unique_ptr<jump_statement_node>
+        node_ptr<expression_statement_node>,
+        node_ptr<compound_statement_node>,
+        node_ptr<selection_statement_node>,
+        node_ptr<declaration_node>,
+        node_ptr<return_statement_node>,
+        node_ptr<iteration_statement_node>,
+        node_ptr<contract_node>,
+        node_ptr<inspect_expression_node>,
+        node_ptr<jump_statement_node>
     > statement;
 
     bool emitted = false;   // note field used during lowering
@@ -1673,7 +1952,7 @@ struct statement_node
     auto get_if()
         -> Node*
     {
-        auto pnode = std::get_if<std::unique_ptr<Node>>(&statement);
+        auto pnode = std::get_if<node_ptr<Node>>(&statement);
         if (pnode) {
             return pnode->get();
         }
@@ -1685,7 +1964,7 @@ struct statement_node
     auto get_if() const
         -> Node const*
     {
-        auto pnode = std::get_if<std::unique_ptr<Node>>(&statement);
+        auto pnode = std::get_if<node_ptr<Node>>(&statement);
         if (pnode) {
             return pnode->get();
         }
@@ -1766,7 +2045,7 @@ struct parameter_declaration_node
     enum class modifier { none=0, implicit, virtual_, override_, final_ };
     modifier mod = modifier::none;
 
-    std::unique_ptr<declaration_node> declaration;
+    node_ptr<declaration_node> declaration;
 
     //  API
     //
@@ -1843,7 +2122,7 @@ struct parameter_declaration_list_node
     token const* open_paren  = {};
     token const* close_paren = {};
 
-    std::vector<std::unique_ptr<parameter_declaration_node>> parameters;
+    std::vector<node_ptr<parameter_declaration_node>> parameters;
 
     //  API
     //
@@ -1908,11 +2187,11 @@ struct function_type_node
 {
     declaration_node* my_decl;
 
-    std::unique_ptr<parameter_declaration_list_node> parameters;
+    node_ptr<parameter_declaration_list_node> parameters;
     bool throws = false;
 
     struct single_type_id {
-        std::unique_ptr<type_id_node> type;
+        node_ptr<type_id_node> type;
         passing_style pass = passing_style::move;
     };
 
@@ -1920,10 +2199,10 @@ struct function_type_node
     std::variant<
         std::monostate,
         single_type_id,
-        std::unique_ptr<parameter_declaration_list_node>
+        node_ptr<parameter_declaration_list_node>
     > returns;
 
-    std::vector<std::unique_ptr<contract_node>> contracts;
+    std::vector<node_ptr<contract_node>> contracts;
 
     function_type_node(declaration_node* decl)
         : my_decl{decl}
@@ -2186,9 +2465,9 @@ struct alias_node
 
     enum active : std::uint8_t { a_type, a_namespace, an_object };
     std::variant<
-        std::unique_ptr<type_id_node>,
-        std::unique_ptr<id_expression_node>,
-        std::unique_ptr<expression_node>
+        node_ptr<type_id_node>,
+        node_ptr<id_expression_node>,
+        node_ptr<expression_node>
     > initializer;
 
     alias_node( token const* t ) : type{t} { }
@@ -2247,25 +2526,35 @@ struct declaration_node
     capture_group captures;
 
     source_position pos;
-    std::unique_ptr<unqualified_id_node> identifier;
+    node_ptr<unqualified_id_node> identifier;
     accessibility access = accessibility::default_;
 
     enum active : std::uint8_t { a_function, an_object, a_type, a_namespace, an_alias };
     std::variant<
-        std::unique_ptr<function_type_node>,
-        std::unique_ptr<type_id_node>,
-        std::unique_ptr<type_node>,
-        std::unique_ptr<namespace_node>,
-        std::unique_ptr<alias_node>
+        node_ptr<function_type_node>,
+        node_ptr<type_id_node>,
+        node_ptr<type_node>,
+        node_ptr<namespace_node>,
+        node_ptr<alias_node>
     > type;
 
-    std::vector<std::unique_ptr<id_expression_node>> meta_functions;
-    std::unique_ptr<parameter_declaration_list_node> template_parameters;
+    std::vector<node_ptr<id_expression_node>> meta_functions;
+    node_ptr<parameter_declaration_list_node> template_parameters;
     source_position                                  requires_pos = {};
-    std::unique_ptr<logical_or_expression_node>      requires_clause_expression;
+    node_ptr<logical_or_expression_node>      requires_clause_expression;
 
     source_position                 equal_sign = {};
-    std::unique_ptr<statement_node> initializer;
+    node_ptr<statement_node> initializer;
+
+    //  When parsing with deferred function bodies, a function body that
+    //  hasn't been parsed yet (and initializer is null): the position of
+    //  its '{' in its section's tokens (see parser::parse_function_body)
+    struct deferred_function_body {
+        std::span<token const> tokens           = {};
+        int                    pos              = 0;
+        std::deque<token>*     generated_tokens = {};
+    };
+    deferred_function_body          deferred_body = {};
 
     declaration_node*               parent_declaration = {};
 
@@ -2427,6 +2716,12 @@ public:
         return initializer != nullptr;
     }
 
+    auto has_deferred_body() const
+        -> bool
+    {
+        return !deferred_body.tokens.empty();
+    }
+
     auto index_of_parameter_named(std::string_view s) const
         -> int
     {
@@ -2593,7 +2888,7 @@ public:
     }
 
 
-    auto add_type_member( std::unique_ptr<statement_node> statement )
+    auto add_type_member( node_ptr<statement_node> statement )
         -> bool
     {
         if (
@@ -3583,7 +3878,7 @@ auto parameter_declaration_node::visit(auto& v, int depth)
 
 struct translation_unit_node
 {
-    std::vector< std::unique_ptr<declaration_node> > declarations;
+    std::vector< node_ptr<declaration_node> > declarations;
 
     auto position() const -> source_position
     {
@@ -3615,7 +3910,7 @@ class parser
 {
     std::vector<error_entry>& errors;
 
-    std::unique_ptr<translation_unit_node> parse_tree = {};
+    node_ptr<translation_unit_node> parse_tree = {};
 
     //  Keep a stack of current capture groups (contracts/decls still being parsed)
     std::vector<capture_group*> current_capture_groups = {};
@@ -3659,7 +3954,7 @@ class parser
         }
     };
 
-    std::vector<token> const* tokens = {};
+    std::span<token const> tokens = {};
     std::deque<token>* generated_tokens = {};
     int pos = 0;
     std::string parse_kind = {};
@@ -3678,7 +3973,36 @@ class parser
     mutable std::vector<function_body_extent> function_body_extents;
     mutable bool                              is_function_body_extents_sorted = false;
 
+    //  Set when parsing already rejected code as violating lifetime safety
+    bool violates_lifetime_safety = false;
+
+    //  Set for the duration of a parse() that defers function bodies
+    bool defer_function_bodies = false;
+
+    //  The tokens generated while parsing on other threads (see
+    //  parse_in_parallel), each thread's in its own store, since the
+    //  parse tree refers to them
+    std::deque<std::deque<token>> parallel_generated_tokens;
+
+    //  The sections parse_sections parsed with deferred function bodies,
+    //  each with the range of errors it added, so that a section whose
+    //  bodies turn out to have errors can be parsed again without
+    //  deferring them (see parse_deferred_function_bodies)
+    struct deferred_section {
+        std::span<token const> tokens;
+        int                    errors_begin = 0;
+        int                    errors_end   = 0;
+    };
+    std::vector<deferred_section> deferred_sections;
+    std::deque<token>*            deferred_generated_tokens = nullptr;
+
 public:
+    auto has_lifetime_safety_violation() const
+        -> bool
+    {
+        return violates_lifetime_safety;
+    }
+
     auto is_within_function_body(source_position p) const
     {
         //  Short circuit the empty case, so that the rest of the function
@@ -3739,12 +4063,12 @@ public:
     //
     parser( std::vector<error_entry>& errors_ )
         : errors{ errors_ }
-        , parse_tree{std::make_unique<translation_unit_node>()}
+        , parse_tree{make_node<translation_unit_node>()}
     { }
 
     parser( parser const& that )
         : errors{ that.errors }
-        , parse_tree{std::make_unique<translation_unit_node>()}
+        , parse_tree{make_node<translation_unit_node>()}
     { }
 
 
@@ -3754,25 +4078,38 @@ public:
     //  tokens              input tokens for this section of Cpp2 source code
     //  generated_tokens    a shared place to store generated tokens
     //
+    //  defer_bodies        skip over function bodies (see below)
+    //
     //  Each call parses this section's worth of tokens and adds the
     //  result to the stored parse tree. Call this repeatedly for the Cpp2
     //  sections in a TU to build the whole TU's parse tree
     //
+    //  With defer_bodies, a braced function body at namespace or type
+    //  scope is just brace-matched and skipped, and its position recorded
+    //  in its declaration_node (except in a type with metafunctions, which
+    //  can look at member function bodies). Then parse_function_body parses
+    //  a body when it's needed. To get the same tree and errors as without
+    //  defer_bodies, parse the sections with parse_sections and then call
+    //  parse_deferred_function_bodies
+    //
     auto parse(
-        std::vector<token> const& tokens_,
-        std::deque<token>&        generated_tokens_
+        std::span<token const> tokens_,
+        std::deque<token>&     generated_tokens_,
+        bool                   defer_bodies = false
     )
         -> bool
     {
         parse_kind = "source file";
 
         //  Set per-parse state for the duration of this call
-        tokens           = &tokens_;
-        generated_tokens = &generated_tokens_;
+        tokens                = tokens_;
+        generated_tokens      = &generated_tokens_;
+        defer_function_bodies = defer_bodies;
 
         //  Generate parse tree for this section as if a standalone TU
         pos     = 0;
         auto tu = translation_unit();
+        defer_function_bodies = false;
 
         //  Then add it to the complete parse tree
         parse_tree->declarations.insert(
@@ -3788,6 +4125,232 @@ public:
     }
 
 
+    //-----------------------------------------------------------------------
+    //  parse_function_body
+    //
+    //  n                   a function whose body parse() deferred
+    //
+    //  Parses the body in the same context it would have been parsed in
+    //  originally, and does the same checks and fixups
+    //
+    auto parse_function_body(declaration_node& n)
+        -> bool
+    {
+        if (!n.has_deferred_body()) {
+            return true;
+        }
+        auto body = std::exchange(n.deferred_body, {});
+
+        //  Set per-parse state for the duration of this call
+        auto saved_tokens           = tokens;
+        auto saved_generated_tokens = generated_tokens;
+        auto saved_pos              = pos;
+        auto saved_declarations     = std::move(current_declarations);
+        tokens           = body.tokens;
+        generated_tokens = body.generated_tokens;
+        pos              = body.pos;
+        parse_kind       = "source file";
+
+        //  Only bodies at namespace or type scope are deferred, so the
+        //  enclosing declarations are just the parents
+        current_declarations = {};
+        for (auto decl = &n; decl; decl = decl->parent_declaration) {
+            current_declarations.push_back(decl);
+        }
+        current_declarations.push_back(nullptr);
+        std::reverse(current_declarations.begin(), current_declarations.end());
+        assert (current_capture_groups.empty());
+
+        auto ok = true;
+        if (!(n.initializer = statement(true, n.equal_sign))) {
+            error(
+                "ill-formed initializer",
+                true, {}, true
+            );
+            ok = false;
+        }
+        else {
+            add_return_to_named_returns_body(n);
+        }
+
+        tokens               = saved_tokens;
+        generated_tokens     = saved_generated_tokens;
+        pos                  = saved_pos;
+        current_declarations = std::move(saved_declarations);
+        return ok;
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  parse_sections
+    //
+    //  sections                each Cpp2 section's tokens, in order
+    //  generated_tokens        a shared place to store generated tokens
+    //  defer_bodies            as for parse()
+    //  parallel_min_sections   with at least this many sections, groups of
+    //                          them are parsed in parallel
+    //  section_parsed          called as (index, result) with each section's
+    //                          result from parse(), in order, after its errors
+    //                          are added
+    //
+    //  Does the same as calling parse() for each section in turn, but may
+    //  parse groups of them on other threads, each with its own errors and
+    //  generated tokens, which are then merged here in section order
+    //
+    static constexpr auto default_parallel_min_sections = 64;
+
+    auto parse_sections(
+        std::span<std::span<token const> const> sections,
+        std::deque<token>&                      generated_tokens_,
+        bool                                    defer_bodies,
+        int                                     parallel_min_sections,
+        auto                                    section_parsed
+    )
+        -> void
+    {
+        deferred_sections.clear();
+        deferred_generated_tokens = nullptr;
+        if (defer_bodies) {
+            for (auto section : sections) {
+                deferred_sections.push_back({ section });
+            }
+            deferred_generated_tokens = &generated_tokens_;
+        }
+
+        auto errors_end = __as<int>(std::ssize(errors));
+        parse_in_parallel(
+            sections,
+            parallel_min_sections,
+            [](std::span<token const> section) { return std::ssize(section); },
+            [&](parser& p, std::span<token const> section, std::deque<token>* generated) {
+                auto span = trace_span{ "section", "parse section", section.empty() ? "" : "at line " + std::to_string(section.front().position().lineno) };
+                return p.parse(section, generated ? *generated : generated_tokens_, defer_bodies);
+            },
+            [&](int i, bool result) {
+                section_parsed(i, result);
+                if (defer_bodies) {
+                    deferred_sections[i].errors_begin = std::exchange(errors_end, __as<int>(std::ssize(errors)));
+                    deferred_sections[i].errors_end   = errors_end;
+                }
+            }
+        );
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  parse_deferred_function_bodies
+    //
+    //  parallel_min_bodies     with at least this many bodies, groups of
+    //                          them are parsed in parallel
+    //  section_parsed          as for parse_sections, called again for each
+    //                          section that is parsed again (see below)
+    //
+    //  Parses all the function bodies that parse() deferred and that
+    //  haven't been parsed yet, in source order (or, in parallel, merging
+    //  their errors in that order)
+    //
+    //  Without deferring, a body with errors would have been reported in
+    //  order with the rest of its section, and a failed one would have
+    //  ended its section's parse. So each section that parse_sections
+    //  parsed and that has a body with errors is parsed again from scratch
+    //  without deferring, and its declarations and errors replaced by the
+    //  new ones, which makes the tree and errors the same as without
+    //  defer_bodies. Sections without errors in their bodies, the usual
+    //  case, are not parsed again
+    //
+    static constexpr auto default_parallel_min_bodies = 64;
+
+    auto parse_deferred_function_bodies(
+        int  parallel_min_bodies,
+        auto section_parsed
+    )
+        -> bool
+    {
+        auto bodies = std::vector<declaration_node*>{};
+        for (auto& decl : parse_tree->declarations) {
+            assert(decl);
+            find_deferred_function_bodies(*decl, bodies);
+        }
+
+        //  Find each body's section before parsing it uses up its tokens
+        auto body_sections = std::vector<int>{};
+        for (auto n : bodies) {
+            auto section = std::find_if(
+                deferred_sections.begin(),
+                deferred_sections.end(),
+                [&](auto const& s) { return s.tokens.data() == n->deferred_body.tokens.data(); }
+            );
+            body_sections.push_back( __as<int>(section - deferred_sections.begin()) );
+        }
+
+        auto errors_before = std::ssize(errors);
+        auto errors_end    = errors_before;
+        auto reparse       = std::vector<bool>(deferred_sections.size(), false);
+        auto ok            = true;
+        parse_in_parallel(
+            std::span<declaration_node* const>{bodies},
+            parallel_min_bodies,
+            [](declaration_node*) { return 1; },
+            [](parser& p, declaration_node* n, std::deque<token>* generated) {
+                if (generated) {
+                    n->deferred_body.generated_tokens = generated;
+                }
+                return p.parse_function_body(*n);
+            },
+            [&](int i, bool result) {
+                ok = ok && result;
+                if (
+                    (!result || std::ssize(errors) > errors_end)
+                    && body_sections[i] < std::ssize(reparse)
+                    )
+                {
+                    reparse[body_sections[i]] = true;
+                }
+                errors_end = std::ssize(errors);
+            }
+        );
+
+        if (std::find(reparse.begin(), reparse.end(), true) == reparse.end()) {
+            return ok;
+        }
+
+        //  All the bodies' errors are in sections that are parsed again, so
+        //  they're all replaced. Go backward so that the earlier sections'
+        //  declarations and errors stay where they were recorded
+        errors.erase(errors.begin() + errors_before, errors.end());
+        ok = true;
+        for (auto i = std::ssize(deferred_sections) - 1; i >= 0; --i)
+        {
+            if (!reparse[i]) {
+                continue;
+            }
+            auto const& section = deferred_sections[i];
+            assert(!section.tokens.empty());
+            auto first = section.tokens.front().position();
+            auto last  = section.tokens.back().position();
+
+            auto& decls = parse_tree->declarations;
+            auto  decls_begin = std::find_if(decls.begin(), decls.end(), [&](auto const& d) { return d->position() >= first; });
+            auto  decls_end   = std::find_if(decls_begin,   decls.end(), [&](auto const& d) { return d->position() >  last; });
+            auto  decls_at    = decls_begin - decls.begin();
+            decls.erase(decls_begin, decls_end);
+            std::erase_if(function_body_extents, [&](auto const& f) { return first.lineno <= f.first && f.first <= last.lineno; });
+            is_function_body_extents_sorted = false;
+            errors.erase(errors.begin() + section.errors_begin, errors.begin() + section.errors_end);
+
+            auto decls_added  = std::ssize(decls);
+            auto errors_added = std::ssize(errors);
+            auto result = parse(section.tokens, *deferred_generated_tokens);
+            section_parsed(__as<int>(i), result);
+            ok = ok && result;
+
+            std::rotate(decls.begin() + decls_at, decls.begin() + decls_added, decls.end());
+            std::rotate(errors.begin() + section.errors_begin, errors.begin() + errors_added, errors.end());
+        }
+        return ok;
+    }
+
+
     //-----------------------------------------------------------------------
     //  parse_one_statement
     //
@@ -3797,15 +4360,15 @@ public:
     //  Each call parses one statement and returns its parse tree.
     //
     auto parse_one_declaration(
-        std::vector<token> const& tokens_,
-        std::deque<token>&        generated_tokens_
+        std::span<token const> tokens_,
+        std::deque<token>&     generated_tokens_
     )
-        -> std::unique_ptr<statement_node>
+        -> node_ptr<statement_node>
     {
         parse_kind = "source string during code generation";
 
         //  Set per-parse state for the duration of this call
-        tokens           = &tokens_;
+        tokens           = tokens_;
         generated_tokens = &generated_tokens_;
 
         //  Parse one declaration - we succeed if the parse succeeded,
@@ -3828,7 +4391,7 @@ public:
     //-----------------------------------------------------------------------
     //  Get a set of pointers to just the declarations in the given token map section
     //
-    auto get_parse_tree_declarations_in_range(std::vector<token> const& token_range) const
+    auto get_parse_tree_declarations_in_range(std::span<token const> token_range) const
         -> std::vector< declaration_node const* >
     {
         assert (parse_tree);
@@ -3922,19 +4485,18 @@ private:
             throw std::runtime_error("unexpected end of " + parse_kind);
         }
 
-        return (*tokens)[pos];
+        return tokens[pos];
     }
 
     auto peek(int num) const
         -> token const*
     {
-        assert (tokens);
         if (
             pos + num >= 0
-            && pos + num < std::ssize(*tokens)
+            && pos + num < std::ssize(tokens)
             )
         {
-            return &(*tokens)[pos + num];
+            return &tokens[pos + num];
         }
         return {};
     }
@@ -3942,16 +4504,14 @@ private:
     auto done() const
         -> bool
     {
-        assert (tokens);
-        assert (pos <= std::ssize(*tokens));
-        return pos == std::ssize(*tokens);
+        assert (pos <= std::ssize(tokens));
+        return pos == std::ssize(tokens);
     }
 
     auto next(int num = 1)
         -> void
     {
-        assert (tokens);
-        pos = std::min( pos+num, __as<int>(std::ssize(*tokens)) );
+        pos = std::min( pos+num, __as<int>(std::ssize(tokens)) );
     }
 
 
@@ -3968,9 +4528,9 @@ private:
     //G     unnamed-declaration
     //G
     auto primary_expression()
-        -> std::unique_ptr<primary_expression_node>
+        -> node_ptr<primary_expression_node>
     {
-        auto n = std::make_unique<primary_expression_node>();
+        auto n = make_node<primary_expression_node>();
 
         if (auto inspect = inspect_expression(true))
         {
@@ -4089,9 +4649,9 @@ private:
     //G     postfix-expression '.' id-expression
     //G
     auto postfix_expression()
-        -> std::unique_ptr<postfix_expression_node>
+        -> node_ptr<postfix_expression_node>
     {
-        auto n = std::make_unique<postfix_expression_node>();
+        auto n = make_node<postfix_expression_node>();
         n->expr = primary_expression();
         if (!(n->expr)) {
             return {};
@@ -4230,9 +4790,9 @@ private:
     //GTODO     throws-expression
     //G
     auto prefix_expression()
-        -> std::unique_ptr<prefix_expression_node>
+        -> node_ptr<prefix_expression_node>
     {
-        auto n = std::make_unique<prefix_expression_node>();
+        auto n = make_node<prefix_expression_node>();
         for ( ;
             is_prefix_operator(curr());
             next()
@@ -4268,23 +4828,27 @@ private:
     //  The general /*binary*/-expression:
     //     /*term*/-expression { { /* operators at this predecence level */ } /*term*/-expression }*
     //
+    //  If there are no operators at this level, this just returns the term
+    //  without making a node for the level (see binary_operand)
+    //
     template<
-        typename Binary,
-        typename ValidateOp,
-        typename TermFunc
+        precedence_level Level,
+        typename         ValidateOp,
+        typename         TermFunc
     >
     auto binary_expression(
         ValidateOp validate_op,
         TermFunc   term
     )
-        -> std::unique_ptr<Binary>
+        -> binary_operand
     {
-        auto n = std::make_unique<Binary>();
-        if ( (n->expr = term()) )
+        auto first = term();
+        if (first)
         {
+            auto n = node_ptr<binary_expression_node>{};
             while (!done())
             {
-                typename Binary::term t{};
+                binary_expression_node::term t{};
 
                 //  Remember current position, because we may need to backtrack if this next
                 //  t.op might be valid but isn't followed by a valid term and so isn't for us
@@ -4329,15 +4893,47 @@ private:
                 //  element and not an operator, it isn't and can't be part of the expression)
                 if ( !(t.expr = term()) ) {
                     pos = term_pos;    // backtrack
-                    return n;
+                    break;
                 }
 
                 //  We got a term, so this op + term was for us
+                if (!n) {
+                    n = make_node<binary_expression_node>();
+                    n->level = Level;
+                    n->expr = std::move(first);
+                }
                 n->terms.push_back( std::move(t) );
             }
-            return n;
+            if (n) {
+                return { std::move(n), {} };
+            }
         }
-        return {};
+        return first;
+    }
+
+    //  For the levels that other productions name: make a node for the
+    //  level even if the expression has no operators at this level
+    //
+    auto binary_expression_node_for(
+        precedence_level level,
+        binary_operand   e
+    )
+        -> node_ptr<binary_expression_node>
+    {
+        if (!e) {
+            return {};
+        }
+        if (
+            e.binary
+            && e.binary->level == level
+            )
+        {
+            return std::move(e.binary);
+        }
+        auto n = make_node<binary_expression_node>();
+        n->level = level;
+        n->expr = std::move(e);
+        return n;
     }
 
     //G multiplicative-expression:
@@ -4347,11 +4943,11 @@ private:
     //G     multiplicative-expression '%' is-as-expression
     //G
     auto multiplicative_expression()
-        -> auto
+        -> binary_operand
     {
-        return binary_expression<multiplicative_expression_node> (
+        return binary_expression<precedence_level::multiplicative> (
             [](token const& t){ return t.type() == lexeme::Multiply || t.type() == lexeme::Slash || t.type() == lexeme::Modulo; },
-            [this]{ return is_as_expression(); }
+            [this]{ return binary_operand{ {}, is_as_expression() }; }
             );
     }
 
@@ -4361,9 +4957,9 @@ private:
     //G     additive-expression '-' multiplicative-expression
     //G
     auto additive_expression()
-        -> auto
+        -> binary_operand
     {
-        return binary_expression<additive_expression_node> (
+        return binary_expression<precedence_level::additive> (
             [](token const& t){ return t.type() == lexeme::Plus || t.type() == lexeme::Minus; },
             [this]{ return multiplicative_expression(); }
         );
@@ -4375,10 +4971,10 @@ private:
     //G     shift-expression '>>' additive-expression
     //G
     auto shift_expression(bool allow_angle_operators = true) 
-        -> auto
+        -> binary_operand
     {
         if (allow_angle_operators) {
-            return binary_expression<shift_expression_node> (
+            return binary_expression<precedence_level::shift> (
                 [this](token const& t, token const& next) -> token const* {
                     if (t.type() == lexeme::LeftShift) {
                         return &t;
@@ -4398,7 +4994,7 @@ private:
             );
         }
         else {
-            return binary_expression<shift_expression_node> (
+            return binary_expression<precedence_level::shift> (
                 [](token const&, token const&) -> token const* { return nullptr; },
                 [this]{ return additive_expression(); }
             );
@@ -4410,9 +5006,9 @@ private:
     //G     compare-expression '<=>' shift-expression
     //G
     auto compare_expression(bool allow_angle_operators = true) 
-        -> auto
+        -> binary_operand
     {
-        return binary_expression<compare_expression_node> (
+        return binary_expression<precedence_level::compare> (
             [](token const& t){ return t.type() == lexeme::Spaceship; },
             [=,this]{ return shift_expression(allow_angle_operators); }
         );
@@ -4426,10 +5022,10 @@ private:
     //G     relational-expression '>=' compare-expression
     //G
     auto relational_expression(bool allow_angle_operators = true) 
-        -> auto
+        -> binary_operand
     {
         if (allow_angle_operators) {
-            return binary_expression<relational_expression_node> (
+            return binary_expression<precedence_level::relational> (
                 [](token const& t, token const& next) -> token const* {
                     if (
                         t.type() == lexeme::Less
@@ -4445,7 +5041,7 @@ private:
             );
         }
         else {
-            return binary_expression<relational_expression_node> (
+            return binary_expression<precedence_level::relational> (
                 [](token const&, token const&) -> token const* { return nullptr; },
                 [=,this]{ return compare_expression(allow_angle_operators); }
             );
@@ -4458,9 +5054,9 @@ private:
     //G     equality-expression '!=' relational-expression
     //G
     auto equality_expression(bool allow_angle_operators = true) 
-        -> auto
+        -> binary_operand
     {
-        return binary_expression<equality_expression_node> (
+        return binary_expression<precedence_level::equality> (
             [](token const& t){ return t.type() == lexeme::EqualComparison || t.type() == lexeme::NotEqualComparison; },
             [=,this]{ return relational_expression(allow_angle_operators); }
         );
@@ -4471,9 +5067,9 @@ private:
     //G     bit-and-expression '&' equality-expression
     //G
     auto bit_and_expression(bool allow_angle_operators = true) 
-        -> auto
+        -> binary_operand
     {
-        return binary_expression<bit_and_expression_node> (
+        return binary_expression<precedence_level::bit_and> (
             [](token const& t){ return t.type() == lexeme::Ampersand; },
             [=,this]{ return equality_expression(allow_angle_operators); }
         );
@@ -4484,9 +5080,9 @@ private:
     //G     bit-xor-expression '^' bit-and-expression
     //G
     auto bit_xor_expression(bool allow_angle_operators = true) 
-        -> auto
+        -> binary_operand
     {
-        return binary_expression<bit_xor_expression_node> (
+        return binary_expression<precedence_level::bit_xor> (
             [](token const& t){ return t.type() == lexeme::Caret; },
             [=,this]{ return bit_and_expression(allow_angle_operators); }
         );
@@ -4497,9 +5093,9 @@ private:
     //G     bit-or-expression '|' bit-xor-expression
     //G
     auto bit_or_expression(bool allow_angle_operators = true) 
-        -> auto
+        -> binary_operand
     {
-        return binary_expression<bit_or_expression_node> (
+        return binary_expression<precedence_level::bit_or> (
             [](token const& t){ return t.type() == lexeme::Pipe; },
             [=,this]{ return bit_xor_expression(allow_angle_operators); }
         );
@@ -4510,9 +5106,9 @@ private:
     //G     logical-and-expression '&&' bit-or-expression
     //G
     auto logical_and_expression(bool allow_angle_operators = true) 
-        -> auto
+        -> binary_operand
     {
-        return binary_expression<logical_and_expression_node> (
+        return binary_expression<precedence_level::logical_and> (
             [](token const& t){ return t.type() == lexeme::LogicalAnd; },
             [=,this]{ return bit_or_expression(allow_angle_operators); }
         );
@@ -4524,10 +5120,22 @@ private:
     //G     logical-and-expression
     //G     logical-or-expression '||' logical-and-expression
     //G
-    auto logical_or_expression(bool allow_angle_operators = true) 
-        -> auto
+    auto logical_or_expression(bool allow_angle_operators = true)
+        -> node_ptr<logical_or_expression_node>
     {
-        return binary_expression<logical_or_expression_node> (
+        return binary_expression_node_for(
+            precedence_level::logical_or,
+            logical_or_operand(allow_angle_operators)
+        );
+    }
+
+    //  A logical-or-expression as the operand of an assignment-expression,
+    //  which doesn't need a node of its own if it has no '||'
+    //
+    auto logical_or_operand(bool allow_angle_operators = true)
+        -> binary_operand
+    {
+        return binary_expression<precedence_level::logical_or> (
             [](token const& t){ return t.type() == lexeme::LogicalOr; },
             [=,this]{ return logical_and_expression(allow_angle_operators); }
         );
@@ -4538,11 +5146,12 @@ private:
     //G     assignment-expression assignment-operator logical-or-expression
     //G
     auto assignment_expression(bool allow_angle_operators = true)
-        -> std::unique_ptr<assignment_expression_node>
+        -> node_ptr<assignment_expression_node>
     {
+        auto e = binary_operand{};
         if (allow_angle_operators)
         {
-            return binary_expression<assignment_expression_node> (
+            e = binary_expression<precedence_level::assignment> (
                 [this](token const& t, token const& next) -> token const* {
                     if (is_assignment_operator(t.type())) {
                         return &t;
@@ -4558,16 +5167,17 @@ private:
                     }
                     return nullptr;
                 },
-                [=,this]{ return logical_or_expression(allow_angle_operators); }
+                [=,this]{ return logical_or_operand(allow_angle_operators); }
             );
         }
         else
         {
-            return binary_expression<assignment_expression_node> (
+            e = binary_expression<precedence_level::assignment> (
                 [](token const&, token const&) -> token const* { return nullptr; },
-                [=,this]{ return logical_or_expression(allow_angle_operators); }
+                [=,this]{ return logical_or_operand(allow_angle_operators); }
             );
         }
+        return binary_expression_node_for(precedence_level::assignment, std::move(e));
     }
 
     //G  expression:                // eliminated 'condition:' - just use 'expression:'
@@ -4575,9 +5185,9 @@ private:
     //GTODO    try expression
     //G
     auto expression(bool allow_angle_operators = true, bool check_arrow = true)
-        -> std::unique_ptr<expression_node>
+        -> node_ptr<expression_node>
     {
-        auto n = std::make_unique<expression_node>();
+        auto n = make_node<expression_node>();
         if (!(n->expr = assignment_expression(allow_angle_operators))) {
             return {};
         }
@@ -4602,10 +5212,10 @@ private:
         token const* open_paren,
         bool inside_initializer = false
     )
-        -> std::unique_ptr<expression_list_node>
+        -> node_ptr<expression_list_node>
     {
         auto pass = passing_style::in;
-        auto n = std::make_unique<expression_list_node>();
+        auto n = make_node<expression_list_node>();
         n->open_paren = open_paren;
         n->inside_initializer = inside_initializer;
 
@@ -4668,9 +5278,9 @@ private:
     //G     '*'
     //G
     auto type_id()
-        -> std::unique_ptr<type_id_node>
+        -> node_ptr<type_id_node>
     {
-        auto n = std::make_unique<type_id_node>();
+        auto n = make_node<type_id_node>();
 
         while (
             (curr().type() == lexeme::Keyword && curr() == "const")
@@ -4728,9 +5338,9 @@ private:
     //G     'as' type-id
     //G
     auto is_as_expression()
-        -> std::unique_ptr<is_as_expression_node>
+        -> node_ptr<is_as_expression_node>
     {
-        auto n = std::make_unique<is_as_expression_node>();
+        auto n = make_node<is_as_expression_node>();
         n->expr = prefix_expression();
         if (!(n->expr)) {
             return {};
@@ -4817,7 +5427,7 @@ private:
     //G     type-id
     //G
     auto unqualified_id()
-        -> std::unique_ptr<unqualified_id_node>
+        -> node_ptr<unqualified_id_node>
     {
         //  Handle the identifier
         if (
@@ -4829,7 +5439,7 @@ private:
             return {};
         }
 
-        auto n = std::make_unique<unqualified_id_node>();
+        auto n = make_node<unqualified_id_node>();
 
         n->identifier = &curr();
         next();
@@ -4910,9 +5520,9 @@ private:
     //G     unqualified-id '.'
     //G
     auto qualified_id()
-        -> std::unique_ptr<qualified_id_node>
+        -> node_ptr<qualified_id_node>
     {
-        auto n = std::make_unique<qualified_id_node>();
+        auto n = make_node<qualified_id_node>();
 
         auto term = qualified_id_node::term{nullptr};
 
@@ -4982,9 +5592,9 @@ private:
     //G     unqualified-id
     //G
     auto id_expression()
-        -> std::unique_ptr<id_expression_node>
+        -> node_ptr<id_expression_node>
     {
-        auto n = std::make_unique<id_expression_node>();
+        auto n = make_node<id_expression_node>();
         if (auto id = qualified_id()) {
             n->pos = id->position();
             n->id  = std::move(id);
@@ -5010,10 +5620,10 @@ private:
     //G     user-defined-literal ud-suffix?
     //G
     auto literal()
-        -> std::unique_ptr<literal_node>
+        -> node_ptr<literal_node>
     {
         if (is_literal(curr().type())) {
-            auto n = std::make_unique<literal_node>();
+            auto n = make_node<literal_node>();
             n->literal = &curr();
             next();
             if (curr().type() == lexeme::UserDefinedLiteralSuffix) {
@@ -5030,9 +5640,9 @@ private:
     //G     expression
     //G
     auto expression_statement(bool semicolon_required)
-        -> std::unique_ptr<expression_statement_node>
+        -> node_ptr<expression_statement_node>
     {
-        auto n = std::make_unique<expression_statement_node>();
+        auto n = make_node<expression_statement_node>();
         if (!(n->expr = expression())) {
             return {};
         }
@@ -5070,7 +5680,7 @@ private:
     //G     'if' 'constexpr'? logical-or-expression compound-statement 'else' compound-statement
     //G
     auto selection_statement()
-        -> std::unique_ptr<selection_statement_node>
+        -> node_ptr<selection_statement_node>
     {
         if (
             curr().type() != lexeme::Keyword
@@ -5079,7 +5689,7 @@ private:
         {
             return {};
         }
-        auto n = std::make_unique<selection_statement_node>();
+        auto n = make_node<selection_statement_node>();
         n->identifier = &curr();
         next();
 
@@ -5121,7 +5731,7 @@ private:
             //  Add empty else branch to simplify processing elsewhere
             //  Note: Position (0,0) signifies it's implicit (no source location)
             n->false_branch =
-                std::make_unique<compound_statement_node>( source_position(0,0) );
+                make_node<compound_statement_node>( source_position(0,0) );
         }
         else {
             n->else_pos = curr().position();
@@ -5154,7 +5764,7 @@ private:
     //G     return expression? ';'
     //G
     auto return_statement()
-        -> std::unique_ptr<return_statement_node>
+        -> node_ptr<return_statement_node>
     {
         if (
             curr().type() != lexeme::Keyword
@@ -5164,7 +5774,7 @@ private:
             return {};
         }
 
-        auto n = std::make_unique<return_statement_node>();
+        auto n = make_node<return_statement_node>();
         n->identifier = &curr();
         next();
 
@@ -5206,9 +5816,9 @@ private:
     //G     'next' assignment-expression
     //G
     auto iteration_statement()
-        -> std::unique_ptr<iteration_statement_node>
+        -> node_ptr<iteration_statement_node>
     {
-        auto n = std::make_unique<iteration_statement_node>();
+        auto n = make_node<iteration_statement_node>();
 
         //  If the next three tokens are:
         //      identifier ':' 'for/while/do'
@@ -5384,9 +5994,9 @@ private:
     //G     unqualified-id :
     //G
     auto alternative()
-        -> std::unique_ptr<alternative_node>
+        -> node_ptr<alternative_node>
     {
-        auto n = std::make_unique<alternative_node>();
+        auto n = make_node<alternative_node>();
 
         //  Now we should be as "is" or "as"
         //  (initial partial implementation, just "is/as id-expression")
@@ -5440,7 +6050,7 @@ private:
     //G     alternative-seq alternative
     //G
     auto inspect_expression(bool is_expression)
-        -> std::unique_ptr<inspect_expression_node>
+        -> node_ptr<inspect_expression_node>
     {
         if (curr() != "inspect") {
             return {};
@@ -5454,7 +6064,7 @@ private:
             return {};
         }
 
-        auto n = std::make_unique<inspect_expression_node>();
+        auto n = make_node<inspect_expression_node>();
         n->identifier = &curr();
         next();
 
@@ -5540,9 +6150,9 @@ private:
     //G     'continue' identifier? ';'
     //G
     auto jump_statement()
-        -> std::unique_ptr<jump_statement_node>
+        -> node_ptr<jump_statement_node>
     {
-        auto n = std::make_unique<jump_statement_node>();
+        auto n = make_node<jump_statement_node>();
 
         if (
             curr() != "break"
@@ -5589,14 +6199,14 @@ private:
         bool                     parameters_allowed = false,
         compound_statement_node* compound_parent    = nullptr
     )
-        -> std::unique_ptr<statement_node>
+        -> node_ptr<statement_node>
     {
         if (!done() && curr().type() == lexeme::Semicolon) {
             error("empty statement is not allowed - remove extra semicolon");
             return {};
         }
 
-        auto n = std::make_unique<statement_node>(compound_parent);
+        auto n = make_node<statement_node>(compound_parent);
 
         //  If a parameter list is allowed here, try to parse one
         if (parameters_allowed) {
@@ -5693,7 +6303,7 @@ private:
         source_position equal_sign                      = source_position{},
         bool            allow_single_unbraced_statement = false
     )
-        -> std::unique_ptr<compound_statement_node>
+        -> node_ptr<compound_statement_node>
     {
         bool is_braced = curr().type() == lexeme::LeftBrace;
         if (
@@ -5704,7 +6314,7 @@ private:
             return {};
         }
 
-        auto n = std::make_unique<compound_statement_node>();
+        auto n = make_node<compound_statement_node>();
         if (!is_braced) {
             n->body_indent = curr().position().colno-1;
         }
@@ -5775,9 +6385,9 @@ private:
         bool is_template  = true,
         bool is_statement = false
     )
-        -> std::unique_ptr<parameter_declaration_node>
+        -> node_ptr<parameter_declaration_node>
     {
-        auto n = std::make_unique<parameter_declaration_node>();
+        auto n = make_node<parameter_declaration_node>();
         n->pass = is_returns ? passing_style::out : passing_style::in;
         n->pos  = curr().position();
 
@@ -5937,7 +6547,7 @@ private:
         bool is_template   = false,
         bool is_statement  = false
     )
-        -> std::unique_ptr<parameter_declaration_list_node>
+        -> node_ptr<parameter_declaration_list_node>
     {
         //  Remember current position, because we need to look ahead in
         //  the case of seeing whether a local statement starts with a
@@ -5956,11 +6566,11 @@ private:
             return {};
         }
 
-        auto n = std::make_unique<parameter_declaration_list_node>();
+        auto n = make_node<parameter_declaration_list_node>();
         n->open_paren = &curr();
         next();
 
-        auto param = std::make_unique<parameter_declaration_node>();
+        auto param = make_node<parameter_declaration_node>();
 
         while ((param = parameter_declaration(is_returns, is_named, is_template, is_statement)) != nullptr)
         {
@@ -6013,7 +6623,7 @@ private:
     //G     'pre' 'post' 'assert'
     //G
     auto contract()
-        -> std::unique_ptr<contract_node>
+        -> node_ptr<contract_node>
     {
         //  Note: For now I'm using [[ ]] mainly so that existing Cpp1 syntax highlighters
         //        don't get confused... I initially implemented single [ ], but then
@@ -6031,7 +6641,7 @@ private:
             return {};
         }
 
-        auto n = std::make_unique<contract_node>(curr().position());
+        auto n = make_node<contract_node>(curr().position());
         auto guard = capture_groups_stack_guard(this, &n->captures);
         next();
         next();
@@ -6110,9 +6720,9 @@ private:
         declaration_node* my_decl,
         bool              is_named = true
         )
-        -> std::unique_ptr<function_type_node>
+        -> node_ptr<function_type_node>
     {
-        auto n = std::make_unique<function_type_node>( my_decl );
+        auto n = make_node<function_type_node>( my_decl );
 
         //  Parameters
         auto parameters = parameter_declaration_list(false, is_named, false);
@@ -6247,12 +6857,12 @@ private:
         bool                                 named                 = false,
         bool                                 is_parameter          = false,
         bool                                 is_template_parameter = false,
-        std::unique_ptr<unqualified_id_node> id                    = {},
+        node_ptr<unqualified_id_node> id                    = {},
         accessibility                        access                = {}
     )
-        -> std::unique_ptr<declaration_node>
+        -> node_ptr<declaration_node>
     {
-        auto n = std::make_unique<declaration_node>( current_declarations.back() );
+        auto n = make_node<declaration_node>( current_declarations.back() );
         n->pos = start;
 
         n->identifier = std::move(id);
@@ -6268,7 +6878,7 @@ private:
             && curr().type() == lexeme::Semicolon
             )
         {
-            n->type = std::make_unique<type_id_node>();
+            n->type = make_node<type_id_node>();
             assert (n->is_object());
             next();
             return n;
@@ -6282,17 +6892,17 @@ private:
             )
         {
             //  So invent the "type" token
-            generated_text.push_back("type");
+            auto text = generated_text.store("type");
             generated_tokens->push_back({
-                generated_text.back().c_str(),
-                std::ssize(generated_text.back()),
+                text.data(),
+                std::ssize(text),
                 start,
                 lexeme::Identifier
             });
 
             //  So we can create the type_node
 
-            auto t = std::make_unique<type_node>( &generated_tokens->back() );
+            auto t = make_node<type_node>( &generated_tokens->back() );
 
             n->type = std::move(t);
             assert (n->is_type());
@@ -6324,20 +6934,20 @@ private:
             )
         {
             //  So invent the "_" token
-            generated_text.push_back("_");
+            auto text = generated_text.store("_");
             generated_tokens->push_back({
-                generated_text.back().c_str(),
-                std::ssize(generated_text.back()),
+                text.data(),
+                std::ssize(text),
                 start,
                 lexeme::Identifier
             });
 
             //  So we can create the typeid_id_node and its unqualified_id_node
 
-            auto gen_id = std::make_unique<unqualified_id_node>();
+            auto gen_id = make_node<unqualified_id_node>();
             gen_id->identifier = &generated_tokens->back();
 
-            auto type = std::make_unique<type_id_node>();
+            auto type = make_node<type_id_node>();
             type->pos = start;
             type->id = std::move(gen_id);
 
@@ -6396,7 +7006,7 @@ private:
                 )
             )
         {
-            n->type = std::make_unique<type_node>( &curr(), curr() == "final" );
+            n->type = make_node<type_node>( &curr(), curr() == "final" );
 
             if (curr() == "final") {
                 next();
@@ -6432,7 +7042,7 @@ private:
         //  Or a namespace
         else if (curr() == "namespace")
         {
-            n->type = std::make_unique<namespace_node>( &curr() );
+            n->type = make_node<namespace_node>( &curr() );
             assert (n->type.index() == declaration_node::a_namespace);
             next();
 
@@ -6484,7 +7094,7 @@ private:
         //  Or nothing, declaring an object of deduced type,
         //  which we'll represent using an empty type-id
         else {
-            n->type = std::make_unique<type_id_node>();
+            n->type = make_node<type_id_node>();
             assert (n->is_object());
             deduced_type = true;
         }
@@ -6580,7 +7190,11 @@ private:
                 }
             }
 
-            if (!(n->initializer = statement(semicolon_required, n->equal_sign))) {
+            if (
+                !defer_function_body(*n)
+                && !(n->initializer = statement(semicolon_required, n->equal_sign))
+                )
+            {
                 error(
                     "ill-formed initializer",
                     true, {}, true
@@ -6603,11 +7217,15 @@ private:
 
         if (
             n->is_function()
-            && n->initializer
+            && (n->initializer || n->has_deferred_body())
             && !done() && curr().type() == lexeme::Semicolon
             )
         {
-            if (n->initializer->is_compound() && n->has_name()) {
+            if (
+                (n->has_deferred_body() || n->initializer->is_compound())
+                && n->has_name()
+                )
+            {
                 error("a braced function body may not be followed by a semicolon (empty statements are not allowed)");
                 return {};
             } else if (n->initializer->is_expression()) {
@@ -6635,39 +7253,314 @@ private:
                 return {};
             }
 
-            auto& body = std::get<statement_node::compound>(n->initializer->statement);
+            add_return_to_named_returns_body(*n);
+        }
+
+        //  If this is a function, record its extents
+        if (n->is_function()) {
+            function_body_extents.emplace_back(
+                n->equal_sign.lineno,
+                peek(-1)->position().lineno
+            );
+        }
+
+        return n;
+    }
+
+
+    //  If this is a function with a list of multiple/named return values,
+    //  and the function body's end doesn't already have "return" as the
+    //  last statement, then generate "return;" as the last statement
+    //
+    auto add_return_to_named_returns_body(declaration_node& n)
+        -> void
+    {
+        auto func = std::get_if<declaration_node::a_function>(&n.type);
+        if (
+            !func
+            || !n.initializer
+            || (*func)->returns.index() != function_type_node::list
+            || !n.initializer->is_compound()
+            )
+        {
+            return;
+        }
+
+        auto& body = std::get<statement_node::compound>(n.initializer->statement);
+
+        if (
+            body->statements.empty()
+            || !body->statements.back()->is_return()
+            )
+        {
+            auto last_pos = n.position();
+            if (!body->statements.empty()) {
+                last_pos = body->statements.back()->position();
+            }
+            ++last_pos.lineno;
+            generated_tokens->emplace_back( "return", last_pos, lexeme::Keyword);
+
+            auto ret = make_node<return_statement_node>();
+            ret->identifier = &generated_tokens->back();
 
+            auto stmt = make_node<statement_node>();
+            stmt->statement = std::move(ret);
+
+            body->statements.push_back(std::move(stmt));
+        }
+    }
+
+
+    //  When parse() is deferring function bodies and this is one that can
+    //  be deferred, skip over it, recording where it is so that
+    //  parse_function_body can parse it later. Only braced bodies at
+    //  namespace or type scope can be, and not in a type with metafunctions
+    //  (they can look at the bodies)
+    //
+    auto defer_function_body(declaration_node& n)
+        -> bool
+    {
+        if (
+            !defer_function_bodies
+            || !n.is_function()
+            || done()
+            || curr().type() != lexeme::LeftBrace
+            || !current_capture_groups.empty()
+            )
+        {
+            return false;
+        }
+        for (auto decl : current_declarations) {
             if (
-                body->statements.empty()
-                || !body->statements.back()->is_return()
+                decl
+                && decl != &n
+                && (
+                    decl->is_function()
+                    || !decl->meta_functions.empty()
+                    )
                 )
             {
-                auto last_pos = n->position();
-                if (!body->statements.empty()) {
-                    last_pos = body->statements.back()->position();
+                return false;
+            }
+        }
+
+        //  Skip to the matching '}'
+        auto start_pos = pos;
+        auto depth     = 0;
+        do {
+            if (curr().type() == lexeme::LeftBrace) {
+                ++depth;
+            }
+            else if (curr().type() == lexeme::RightBrace) {
+                --depth;
+            }
+            next();
+        } while (depth > 0 && !done());
+
+        //  If the braces don't match, leave it to the parse to report
+        if (depth > 0) {
+            pos = start_pos;
+            return false;
+        }
+
+        n.deferred_body = { tokens, start_pos, generated_tokens };
+        return true;
+    }
+
+    auto find_deferred_function_bodies(
+        declaration_node&               n,
+        std::vector<declaration_node*>& bodies
+    )
+        -> void
+    {
+        if (n.has_deferred_body()) {
+            bodies.push_back(&n);
+        }
+
+        //  Deferred bodies are only at namespace or type scope
+        else if (
+            (n.is_namespace() || n.is_type())
+            && n.initializer
+            )
+        {
+            if (auto body = n.initializer->get_if<compound_statement_node>()) {
+                for (auto& stmt : body->statements) {
+                    if (auto decl = stmt->get_if<declaration_node>()) {
+                        find_deferred_function_bodies(*decl, bodies);
+                    }
                 }
-                ++last_pos.lineno;
-                generated_tokens->emplace_back( "return", last_pos, lexeme::Keyword);
+            }
+        }
+    }
 
-                auto ret = std::make_unique<return_statement_node>();
-                ret->identifier = &generated_tokens->back();
 
-                auto stmt = std::make_unique<statement_node>();
-                stmt->statement = std::move(ret);
+    //  What a group of items parsed on another thread produced, all of which
+    //  this thread takes over: the thread's nodes and generated text, tokens,
+    //  and lexers (for code generated by metafunctions), plus what its parser
+    //  produced, and its errors, with where each item's end
+    //
+    struct parallel_part {
+        node_arena                              nodes;
+        text_arena                              text;
+        std::deque<cpp2::tokens>                lexers;
+        std::deque<token>                       generated;
+        std::vector<error_entry>                errors;
+        std::vector<int>                        error_ends;
+        std::vector<bool>                       results;
+        std::vector<node_ptr<declaration_node>> declarations;
+        std::vector<function_body_extent>       extents;
+        bool                                    violates_lifetime_safety = false;
+        std::exception_ptr                      exception;
+    };
 
-                body->statements.push_back(std::move(stmt));
+    //  Parse each item with parse_item(parser, item, generated), calling
+    //  item_parsed(index, result) on this thread in order
+    //
+    //  With enough items, they are split into one group per thread with
+    //  about the same total weight, and the groups after the first are
+    //  parsed in parallel by their own parsers while this thread does the
+    //  first group. Then everything the other threads made is taken over,
+    //  and their results merged in order, so the parse tree and errors are
+    //  the same as parsing the items in turn here (if parsing one throws,
+    //  the items after it are dropped and the exception is rethrown here)
+    //
+    //  generated is null for this thread, else the other thread's own store
+    //  for generated tokens
+    //
+    template<typename Item>
+    auto parse_in_parallel(
+        std::span<Item const> items,
+        int                   parallel_min_items,
+        auto                  weight,
+        auto                  parse_item,
+        auto                  item_parsed
+    )
+        -> void
+    {
+        auto parse_here = [&](int first, int last) {
+            for (auto i = first; i < last; ++i) {
+                item_parsed(i, parse_item(*this, items[i], nullptr));
             }
+        };
+
+        auto threads = parallel_threads();
+        if (
+            std::ssize(items) < parallel_min_items
+            || threads < 2
+            )
+        {
+            parse_here(0, __as<int>(std::ssize(items)));
+            return;
         }
 
-        //  If this is a function, record its extents
-        if (n->is_function()) {
-            function_body_extents.emplace_back(
-                n->equal_sign.lineno,
-                peek(-1)->position().lineno
+        auto total_weight = std::int64_t{0};
+        for (auto const& item : items) {
+            total_weight += weight(item);
+        }
+
+        auto group_starts = std::vector<int>{ 0 };
+        auto group_weight = std::int64_t{0};
+        for (auto i = 0; i < std::ssize(items); ++i) {
+            if (
+                group_weight >= total_weight / threads * std::ssize(group_starts)
+                && i != group_starts.back()
+                )
+            {
+                group_starts.push_back(i);
+            }
+            group_weight += weight(items[i]);
+        }
+        group_starts.push_back(__as<int>(std::ssize(items)));
+
+        auto parts = std::vector<std::future<parallel_part>>{};
+        for (auto g = 1; g+1 < std::ssize(group_starts); ++g)
+        {
+            parts.push_back( std::async(
+                std::launch::async,
+                [&items, &parse_item, first = group_starts[g], last = group_starts[g+1]] {
+                    //  Names are interned by the thread that takes the tokens over
+                    auto my_symbols = std::exchange(symbols, nullptr);
+
+                    auto ret = parallel_part{};
+                    {
+                        auto p = parser{ ret.errors };
+                        for (auto i = first; i < last; ++i) {
+                            try {
+                                ret.results.push_back( parse_item(p, items[i], &ret.generated) );
+                            }
+                            catch (...) {
+                                ret.exception = std::current_exception();
+                                break;
+                            }
+                            ret.error_ends.push_back( __as<int>(std::ssize(ret.errors)) );
+                        }
+                        ret.declarations             = std::move(p.parse_tree->declarations);
+                        ret.extents                  = std::move(p.function_body_extents);
+                        ret.violates_lifetime_safety = p.violates_lifetime_safety;
+                    }
+
+                    ret.nodes  = std::exchange(parse_nodes,      {});
+                    ret.text   = std::exchange(generated_text,   {});
+                    ret.lexers = std::exchange(generated_lexers, {});
+                    symbols    = my_symbols;
+                    return ret;
+                }
+            ) );
+        }
+
+        auto exception = std::exception_ptr{};
+        try {
+            parse_here(group_starts[0], group_starts[1]);
+        }
+        catch (...) {
+            exception = std::current_exception();
+        }
+
+        //  Take over everything the other threads made, even if an exception
+        //  means their results will be dropped, so that those are destroyed
+        //  as this thread's own
+        auto results = std::deque<parallel_part>{};
+        for (auto& part : parts) {
+            auto& r = results.emplace_back( part.get() );
+            parse_nodes   .adopt( std::move(r.nodes) );
+            generated_text.adopt( std::move(r.text) );
+            for (auto& lexer : r.lexers) {
+                lexer.intern_names();
+                generated_lexers.push_back( std::move(lexer) );
+            }
+            for (auto& t : r.generated) {
+                t.set_type( t.type() );
+            }
+            parallel_generated_tokens.push_back( std::move(r.generated) );
+        }
+
+        //  Then merge their results in order
+        for (auto g = 0; g < std::ssize(results) && !exception; ++g)
+        {
+            auto& r = results[g];
+            auto  e = r.errors.begin();
+            for (auto i = 0; i < std::ssize(r.results); ++i) {
+                errors.insert(errors.end(), e, r.errors.begin() + r.error_ends[i]);
+                e = r.errors.begin() + r.error_ends[i];
+                item_parsed(group_starts[g+1] + i, r.results[i]);
+            }
+            errors.insert(errors.end(), e, r.errors.end());
+
+            parse_tree->declarations.insert(
+                parse_tree->declarations.end(),
+                std::make_move_iterator(r.declarations.begin()),
+                std::make_move_iterator(r.declarations.end())
             );
+            function_body_extents.insert(function_body_extents.end(), r.extents.begin(), r.extents.end());
+            is_function_body_extents_sorted = false;
+            violates_lifetime_safety = violates_lifetime_safety || r.violates_lifetime_safety;
+
+            exception = r.exception;
         }
 
-        return n;
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
     }
 
 
@@ -6681,12 +7574,12 @@ private:
     //GT        # for why I don't see a need to enable this yet
     //
     auto alias()
-        -> std::unique_ptr<declaration_node>
+        -> node_ptr<declaration_node>
     {
         //  Remember current position, because we need to look ahead
         auto start_pos = pos;
 
-        auto n = std::make_unique<declaration_node>( current_declarations.back() );
+        auto n = make_node<declaration_node>( current_declarations.back() );
 
         if (curr().type() != lexeme::Colon) {
             return {};
@@ -6730,7 +7623,7 @@ private:
 
         //  Resume parsing
 
-        auto a = std::make_unique<alias_node>( &curr() );
+        auto a = make_node<alias_node>( &curr() );
         next();
 
         if (curr().type() == lexeme::EqualComparison) {
@@ -6850,14 +7743,14 @@ private:
         bool is_parameter          = false,
         bool is_template_parameter = false
     )
-        -> std::unique_ptr<declaration_node>
+        -> node_ptr<declaration_node>
     {
         if (done()) { return {}; }
 
         //  Remember current position, because we need to look ahead
         auto start_pos = pos;
 
-        auto n = std::unique_ptr<declaration_node>{};
+        auto n = node_ptr<declaration_node>{};
 
         //  This scope is to ensure that once we've moved 'id' into the
         //  declaration_node, we don't access the moved-from local name
@@ -7036,9 +7929,9 @@ private:
     //G     declaration-seq?
     //
     auto translation_unit()
-        -> std::unique_ptr<translation_unit_node>
+        -> node_ptr<translation_unit_node>
     {
-        auto n = std::make_unique<translation_unit_node>();
+        auto n = make_node<translation_unit_node>();
         for (auto d = declaration(); d; d = declaration()) {
             n->declarations.push_back( std::move(d) );
         }
@@ -7141,10 +8034,9 @@ public:
         o << pre(indent) << "is-as-expression\n";
     }
 
-    template<String Name, typename Term>
-    auto start(binary_expression_node<Name, Term> const&, int indent) -> void
+    auto start(binary_expression_node const& n, int indent) -> void
     {
-        o << pre(indent) << Name.value << "-expression\n";
+        o << pre(indent) << to_string_view(n.level) << "-expression\n";
     }
 
     auto start(expression_statement_node const&, int indent) -> void
@@ -17,22 +17,22 @@ namespace meta {
 #line 32 "reflect.h2"
 class compiler_services;
 
-#line 177 "reflect.h2"
+#line 180 "reflect.h2"
 class declaration_base;
 
-#line 201 "reflect.h2"
+#line 204 "reflect.h2"
 class declaration;
 
-#line 264 "reflect.h2"
+#line 267 "reflect.h2"
 class function_declaration;
 
-#line 321 "reflect.h2"
+#line 324 "reflect.h2"
 class object_declaration;
 
-#line 357 "reflect.h2"
+#line 360 "reflect.h2"
 class type_declaration;
 
-#line 818 "reflect.h2"
+#line 821 "reflect.h2"
 }
 }
 
@@ -94,27 +94,27 @@ class compiler_services
 
         std::string_view source
     ) -> 
-        std::unique_ptr<statement_node>;
+        node_ptr<statement_node>;
 
-#line 104 "reflect.h2"
+#line 107 "reflect.h2"
     public: [[nodiscard]] virtual auto position() const -> 
         source_position; 
 
-#line 110 "reflect.h2"
+#line 113 "reflect.h2"
     public: auto require(
 
         cpp2::in<bool> b, 
         cpp2::in<std::string_view> msg
     ) const -> void;
 
-#line 121 "reflect.h2"
+#line 124 "reflect.h2"
     public: auto error(cpp2::in<std::string_view> msg) const -> void;
     
     public: virtual ~compiler_services() noexcept;
 public: compiler_services(compiler_services const& that);
 
 
-#line 129 "reflect.h2"
+#line 132 "reflect.h2"
 };
 
 /*
@@ -131,11 +131,11 @@ type_id: @polymorphic_base @copyable type =
 {
     this: compiler_services = ();
 
-    n: type_id_node;
+    n: *type_id_node;
 
     protected operator=: (
         out this,
-        n_: type_id_node,
+        n_: *type_id_node,
         s : compiler_services
     )
     = {
@@ -144,16 +144,16 @@ type_id: @polymorphic_base @copyable type =
         [[assert: n, "a meta::type_id must point to a valid type_id_node, not null"]]
     }
 
-    is_wildcard         : (this) -> bool        = n.is_wildcard();
-    is_pointer_qualified: (this) -> bool        = n.is_pointer_qualified();
-    template_args_count : (this) -> int         = n.template_args_count();
-    to_string           : (this) -> std::string = n.to_string();
+    is_wildcard         : (this) -> bool        = n*.is_wildcard();
+    is_pointer_qualified: (this) -> bool        = n*.is_pointer_qualified();
+    template_args_count : (this) -> int         = n*.template_args_count();
+    to_string           : (this) -> std::string = n*.to_string();
 
-    position: (override this) -> source_position = n.position();
+    position: (override this) -> source_position = n*.position();
 }
 */
 
-#line 168 "reflect.h2"
+#line 171 "reflect.h2"
 //-----------------------------------------------------------------------
 //
 //  Declarations
@@ -166,7 +166,7 @@ type_id: @polymorphic_base @copyable type =
 class declaration_base
 : public compiler_services {
 
-#line 181 "reflect.h2"
+#line 184 "reflect.h2"
     protected: declaration_node* n; 
 
     protected: explicit declaration_base(
@@ -175,29 +175,29 @@ class declaration_base
         cpp2::in<compiler_services> s
     );
 
-#line 194 "reflect.h2"
+#line 197 "reflect.h2"
     public: [[nodiscard]] auto position() const -> source_position override;
 
 public: virtual ~declaration_base() noexcept;
 public: declaration_base(declaration_base const& that);
-#line 195 "reflect.h2"
+#line 198 "reflect.h2"
 };
 
-#line 198 "reflect.h2"
+#line 201 "reflect.h2"
 //-----------------------------------------------------------------------
 //  All declarations
 //
 class declaration
 : public declaration_base {
 
-#line 205 "reflect.h2"
+#line 208 "reflect.h2"
     public: explicit declaration(
 
         declaration_node* n_, 
         cpp2::in<compiler_services> s
     );
 
-#line 214 "reflect.h2"
+#line 217 "reflect.h2"
     public: [[nodiscard]] auto is_public() const -> bool;
     public: [[nodiscard]] auto is_protected() const -> bool;
     public: [[nodiscard]] auto is_private() const -> bool;
@@ -217,7 +217,7 @@ class declaration
     public: [[nodiscard]] auto name() const -> std::string_view;
         
 
-#line 235 "reflect.h2"
+#line 238 "reflect.h2"
     public: [[nodiscard]] auto has_initializer() const -> bool;
 
     public: [[nodiscard]] auto is_global() const -> bool;
@@ -244,24 +244,24 @@ class declaration
 
 public: virtual ~declaration() noexcept;
 public: declaration(declaration const& that);
-#line 258 "reflect.h2"
+#line 261 "reflect.h2"
 };
 
-#line 261 "reflect.h2"
+#line 264 "reflect.h2"
 //-----------------------------------------------------------------------
 //  Function declarations
 //
 class function_declaration
 : public declaration {
 
-#line 268 "reflect.h2"
+#line 271 "reflect.h2"
     public: explicit function_declaration(
 
         declaration_node* n_, 
         cpp2::in<compiler_services> s
     );
 
-#line 278 "reflect.h2"
+#line 281 "reflect.h2"
     public: [[nodiscard]] auto index_of_parameter_named(cpp2::in<std::string_view> s) const -> int;
     public: [[nodiscard]] auto has_parameter_named(cpp2::in<std::string_view> s) const -> bool;
     public: [[nodiscard]] auto has_in_parameter_named(cpp2::in<std::string_view> s) const -> bool;
@@ -301,54 +301,54 @@ class function_declaration
     public: [[nodiscard]] auto make_virtual() -> bool;
 
 public: function_declaration(function_declaration const& that);
-#line 315 "reflect.h2"
+#line 318 "reflect.h2"
 };
 
-#line 318 "reflect.h2"
+#line 321 "reflect.h2"
 //-----------------------------------------------------------------------
 //  Object declarations
 //
 class object_declaration
 : public declaration {
 
-#line 325 "reflect.h2"
+#line 328 "reflect.h2"
     public: explicit object_declaration(
 
         declaration_node* n_, 
         cpp2::in<compiler_services> s
     );
 
-#line 335 "reflect.h2"
+#line 338 "reflect.h2"
     public: [[nodiscard]] auto is_const() const -> bool;
     public: [[nodiscard]] auto has_wildcard_type() const -> bool;
 
     public: [[nodiscard]] auto type() const -> std::string;
         
 
-#line 345 "reflect.h2"
+#line 348 "reflect.h2"
     public: [[nodiscard]] auto initializer() const -> std::string;
         
         public: object_declaration(object_declaration const& that);
 
 
-#line 351 "reflect.h2"
+#line 354 "reflect.h2"
 };
 
-#line 354 "reflect.h2"
+#line 357 "reflect.h2"
 //-----------------------------------------------------------------------
 //  Type declarations
 //
 class type_declaration
 : public declaration {
 
-#line 361 "reflect.h2"
+#line 364 "reflect.h2"
     public: explicit type_declaration(
 
         declaration_node* n_, 
         cpp2::in<compiler_services> s
     );
 
-#line 371 "reflect.h2"
+#line 374 "reflect.h2"
     public: [[nodiscard]] auto is_polymorphic() const -> bool;
     public: [[nodiscard]] auto is_final() const -> bool;
     public: [[nodiscard]] auto make_final() -> bool;
@@ -356,38 +356,38 @@ class type_declaration
     public: [[nodiscard]] auto get_member_functions() const -> 
         std::vector<function_declaration>; 
 
-#line 385 "reflect.h2"
+#line 388 "reflect.h2"
     public: [[nodiscard]] auto get_member_objects() const -> 
         std::vector<object_declaration>; 
 
-#line 395 "reflect.h2"
+#line 398 "reflect.h2"
     public: [[nodiscard]] auto get_member_types() const -> 
         std::vector<type_declaration>; 
 
-#line 405 "reflect.h2"
+#line 408 "reflect.h2"
     public: [[nodiscard]] auto get_members() const -> 
         std::vector<declaration>; struct query_declared_value_set_functions__ret { bool out_this_in_that; bool out_this_move_that; bool inout_this_in_that; bool inout_this_move_that; };
 
 
 
-#line 415 "reflect.h2"
+#line 418 "reflect.h2"
     public: [[nodiscard]] auto query_declared_value_set_functions() const -> query_declared_value_set_functions__ret;
         
 
-#line 430 "reflect.h2"
+#line 433 "reflect.h2"
     public: [[nodiscard]] auto add_member(cpp2::in<std::string_view> source) -> 
         bool; 
 
-#line 440 "reflect.h2"
+#line 443 "reflect.h2"
     public: auto remove_all_members() -> void;
 
     public: auto disable_member_function_generation() -> void;
 
 public: type_declaration(type_declaration const& that);
-#line 443 "reflect.h2"
+#line 446 "reflect.h2"
 };
 
-#line 446 "reflect.h2"
+#line 449 "reflect.h2"
 //-----------------------------------------------------------------------
 //
 //  Metafunctions - these are hardwired for now until we get to the
@@ -402,7 +402,7 @@ public: type_declaration(type_declaration const& that);
 //
 auto add_virtual_destructor(meta::type_declaration& t) -> void;
 
-#line 465 "reflect.h2"
+#line 468 "reflect.h2"
 //-----------------------------------------------------------------------
 //
 //      "... an abstract base class defines an interface ..."
@@ -417,7 +417,7 @@ auto add_virtual_destructor(meta::type_declaration& t) -> void;
 //
 auto interface(meta::type_declaration& t) -> void;
 
-#line 504 "reflect.h2"
+#line 507 "reflect.h2"
 //-----------------------------------------------------------------------
 //
 //     "C.35: A base class destructor should be either public and
@@ -439,7 +439,7 @@ auto interface(meta::type_declaration& t) -> void;
 //
 auto polymorphic_base(meta::type_declaration& t) -> void;
 
-#line 548 "reflect.h2"
+#line 551 "reflect.h2"
 //-----------------------------------------------------------------------
 //
 //     "... A totally ordered type ... requires operator<=> that
@@ -465,7 +465,7 @@ auto ordered_impl(
     cpp2::in<std::string_view> ordering// must be "strong_ordering" etc.
 ) -> void;
 
-#line 593 "reflect.h2"
+#line 596 "reflect.h2"
 //-----------------------------------------------------------------------
 //  ordered - a totally ordered type
 //
@@ -473,19 +473,19 @@ auto ordered_impl(
 //
 auto ordered(meta::type_declaration& t) -> void;
 
-#line 603 "reflect.h2"
+#line 606 "reflect.h2"
 //-----------------------------------------------------------------------
 //  weakly_ordered - a weakly ordered type
 //
 auto weakly_ordered(meta::type_declaration& t) -> void;
 
-#line 611 "reflect.h2"
+#line 614 "reflect.h2"
 //-----------------------------------------------------------------------
 //  partially_ordered - a partially ordered type
 //
 auto partially_ordered(meta::type_declaration& t) -> void;
 
-#line 620 "reflect.h2"
+#line 623 "reflect.h2"
 //-----------------------------------------------------------------------
 //
 //     "A value is ... a regular type. It must have all public
@@ -504,7 +504,7 @@ auto partially_ordered(meta::type_declaration& t) -> void;
 //
 auto copyable(meta::type_declaration& t) -> void;
 
-#line 658 "reflect.h2"
+#line 661 "reflect.h2"
 //-----------------------------------------------------------------------
 //
 //  basic_value
@@ -514,7 +514,7 @@ auto copyable(meta::type_declaration& t) -> void;
 //
 auto basic_value(meta::type_declaration& t) -> void;
 
-#line 684 "reflect.h2"
+#line 687 "reflect.h2"
 //-----------------------------------------------------------------------
 //
 //     "A 'value' is a totally ordered basic_value..."
@@ -527,13 +527,13 @@ auto basic_value(meta::type_declaration& t) -> void;
 //
 auto value(meta::type_declaration& t) -> void;
 
-#line 700 "reflect.h2"
+#line 703 "reflect.h2"
 auto weakly_ordered_value(meta::type_declaration& t) -> void;
 
-#line 706 "reflect.h2"
+#line 709 "reflect.h2"
 auto partially_ordered_value(meta::type_declaration& t) -> void;
 
-#line 713 "reflect.h2"
+#line 716 "reflect.h2"
 //-----------------------------------------------------------------------
 //
 //     "By definition, a `struct` is a `class` in which members
@@ -561,7 +561,7 @@ auto partially_ordered_value(meta::type_declaration& t) -> void;
 //
 auto cpp2_struct(meta::type_declaration& t) -> void;
 
-#line 756 "reflect.h2"
+#line 759 "reflect.h2"
 /*
 //-----------------------------------------------------------------------
 //
@@ -621,7 +621,7 @@ basic_enum: (inout t: meta::type_declaration) =
 }
 */
 
-#line 816 "reflect.h2"
+#line 819 "reflect.h2"
 //=======================================================================
 //  Switch to Cpp1 and close subnamespace meta
 }
@@ -648,6 +648,7 @@ auto parser::apply_type_meta_functions( declaration_node& n )
     //  For each metafunction, apply it
     for (auto& meta : n.meta_functions)
     {
+        auto span = trace_span{ "metafunction", "@" + meta->to_string(), n.has_name() ? n.name()->as_string_view() : "" };
         rtype.set_meta_function_name( meta->to_string() );
 
         if (meta->to_string() == "interface") {
@@ -727,10 +728,14 @@ namespace meta {
 
         std::string_view source
     ) -> 
-        std::unique_ptr<statement_node>
+        node_ptr<statement_node>
     {
-        CPP2_UFCS(push_back, generated_lines, std::vector<source_line>());
-        auto lines {&CPP2_UFCS_0(back, generated_lines)}; 
+        //  The source_lines will be views, so first make the text stable
+        source = CPP2_UFCS(store, generated_text, source);
+
+        //  The lines are only needed while lexing, so reuse the scratch lines
+        auto lines {&generated_lines}; 
+        CPP2_UFCS_0(clear, (*cpp2::assert_not_null(lines)));
 
         auto add_line {[&, _1 = lines](cpp2::in<std::string_view> s) -> void{
             (void) CPP2_UFCS(emplace_back, (*cpp2::assert_not_null(_1)), s, source_line::category::cpp2);
@@ -741,7 +746,7 @@ auto newline_pos = CPP2_UFCS(find, source, '\n');
         //  First split this string into source_lines
         //
 
-#line 72 "reflect.h2"
+#line 76 "reflect.h2"
         if ( cpp2::cmp_greater(CPP2_UFCS_0(ssize, source),1) 
             && newline_pos!=source.npos) 
         {
@@ -754,24 +759,23 @@ auto newline_pos = CPP2_UFCS(find, source, '\n');
         }
 }
 
-#line 83 "reflect.h2"
+#line 87 "reflect.h2"
         if (!(CPP2_UFCS_0(empty, source))) {
             std::move(add_line)(std::move(source));
         }
 
         //  Now lex this source fragment to generate
-        //  a single grammar_map entry, whose .second
-        //  is the vector of tokens
+        //  a single section of tokens
         (void) CPP2_UFCS(emplace_back, generated_lexers, *cpp2::assert_not_null(errors));
         auto tokens {&CPP2_UFCS_0(back, generated_lexers)}; 
         CPP2_UFCS(lex, (*cpp2::assert_not_null(tokens)), *cpp2::assert_not_null(std::move(lines)), true);
 
-        cpp2::Default.expects(std::ssize(CPP2_UFCS_0(get_map, (*cpp2::assert_not_null(tokens))))==1, "");
+        cpp2::Default.expects(std::ssize(CPP2_UFCS_0(get_sections, (*cpp2::assert_not_null(tokens))))==1, "");
 
         //  Now parse this single declaration from
         //  the lexed tokens
         return CPP2_UFCS(parse_one_declaration, parser, 
-            (*cpp2::assert_not_null(CPP2_UFCS_0(begin, CPP2_UFCS_0(get_map, *cpp2::assert_not_null(std::move(tokens)))))).second, 
+            CPP2_UFCS(get_tokens, (*cpp2::assert_not_null(tokens)), CPP2_UFCS_0(front, CPP2_UFCS_0(get_sections, (*cpp2::assert_not_null(std::move(tokens)))))), 
             *cpp2::assert_not_null(generated_tokens)
         ); 
     }
@@ -810,7 +814,7 @@ compiler_services::compiler_services(compiler_services const& that)
                                 , parser{ that.parser }
                                 , meta_function_name{ that.meta_function_name }{}
 
-#line 183 "reflect.h2"
+#line 186 "reflect.h2"
     declaration_base::declaration_base(
 
         declaration_node* n_, 
@@ -818,10 +822,10 @@ compiler_services::compiler_services(compiler_services const& that)
     )
         : compiler_services{ s }
         , n{ n_ }
-#line 188 "reflect.h2"
+#line 191 "reflect.h2"
     {
 
-#line 191 "reflect.h2"
+#line 194 "reflect.h2"
         cpp2::Default.expects(n, "a meta::declaration must point to a valid declaration_node, not null");
     }
 
@@ -832,14 +836,14 @@ declaration_base::declaration_base(declaration_base const& that)
                                 : compiler_services{ that }
                                 , n{ that.n }{}
 
-#line 205 "reflect.h2"
+#line 208 "reflect.h2"
     declaration::declaration(
 
         declaration_node* n_, 
         cpp2::in<compiler_services> s
     )
         : declaration_base{ n_, s }
-#line 210 "reflect.h2"
+#line 213 "reflect.h2"
     {
 
     }
@@ -893,14 +897,14 @@ declaration_base::declaration_base(declaration_base const& that)
 declaration::declaration(declaration const& that)
                                 : declaration_base{ that }{}
 
-#line 268 "reflect.h2"
+#line 271 "reflect.h2"
     function_declaration::function_declaration(
 
         declaration_node* n_, 
         cpp2::in<compiler_services> s
     )
         : declaration{ n_, s }
-#line 273 "reflect.h2"
+#line 276 "reflect.h2"
     {
 
         cpp2::Default.expects(CPP2_UFCS_0(is_function, (*cpp2::assert_not_null(n))), "");
@@ -947,14 +951,14 @@ declaration::declaration(declaration const& that)
     function_declaration::function_declaration(function_declaration const& that)
                                 : declaration{ that }{}
 
-#line 325 "reflect.h2"
+#line 328 "reflect.h2"
     object_declaration::object_declaration(
 
         declaration_node* n_, 
         cpp2::in<compiler_services> s
     )
         : declaration{ n_, s }
-#line 330 "reflect.h2"
+#line 333 "reflect.h2"
     {
 
         cpp2::Default.expects(CPP2_UFCS_0(is_object, (*cpp2::assert_not_null(n))), "");
@@ -980,14 +984,14 @@ declaration::declaration(declaration const& that)
     object_declaration::object_declaration(object_declaration const& that)
                                 : declaration{ that }{}
 
-#line 361 "reflect.h2"
+#line 364 "reflect.h2"
     type_declaration::type_declaration(
 
         declaration_node* n_, 
         cpp2::in<compiler_services> s
     )
         : declaration{ n_, s }
-#line 366 "reflect.h2"
+#line 369 "reflect.h2"
     {
 
         cpp2::Default.expects(CPP2_UFCS_0(is_type, (*cpp2::assert_not_null(n))), "");
@@ -1039,13 +1043,13 @@ declaration::declaration(declaration const& that)
 
     [[nodiscard]] auto type_declaration::query_declared_value_set_functions() const -> query_declared_value_set_functions__ret
 
-#line 422 "reflect.h2"
+#line 425 "reflect.h2"
     {
             cpp2::deferred_init<bool> out_this_in_that;
             cpp2::deferred_init<bool> out_this_move_that;
             cpp2::deferred_init<bool> inout_this_in_that;
             cpp2::deferred_init<bool> inout_this_move_that;
-#line 423 "reflect.h2"
+#line 426 "reflect.h2"
         auto declared {CPP2_UFCS_0(find_declared_value_set_functions, (*cpp2::assert_not_null(n)))}; 
         out_this_in_that.construct(declared.out_this_in_that != nullptr);
         out_this_move_that.construct(declared.out_this_move_that!=nullptr);
@@ -1070,14 +1074,14 @@ declaration::declaration(declaration const& that)
     type_declaration::type_declaration(type_declaration const& that)
                                 : declaration{ that }{}
 
-#line 458 "reflect.h2"
+#line 461 "reflect.h2"
 auto add_virtual_destructor(meta::type_declaration& t) -> void
 {
     CPP2_UFCS(require, t, CPP2_UFCS(add_member, t, "operator=: (virtual move this) = { }"), 
                "could not add virtual destructor");
 }
 
-#line 477 "reflect.h2"
+#line 480 "reflect.h2"
 auto interface(meta::type_declaration& t) -> void
 {
     auto has_dtor {false}; 
@@ -1104,7 +1108,7 @@ auto interface(meta::type_declaration& t) -> void
     }
 }
 
-#line 523 "reflect.h2"
+#line 526 "reflect.h2"
 auto polymorphic_base(meta::type_declaration& t) -> void
 {
     auto has_dtor {false}; 
@@ -1129,7 +1133,7 @@ auto polymorphic_base(meta::type_declaration& t) -> void
     }
 }
 
-#line 568 "reflect.h2"
+#line 571 "reflect.h2"
 auto ordered_impl(
     meta::type_declaration& t, 
     cpp2::in<std::string_view> ordering
@@ -1155,25 +1159,25 @@ auto ordered_impl(
     }
 }
 
-#line 598 "reflect.h2"
+#line 601 "reflect.h2"
 auto ordered(meta::type_declaration& t) -> void
 {
     ordered_impl(t, "strong_ordering");
 }
 
-#line 606 "reflect.h2"
+#line 609 "reflect.h2"
 auto weakly_ordered(meta::type_declaration& t) -> void
 {
     ordered_impl(t, "weak_ordering");
 }
 
-#line 614 "reflect.h2"
+#line 617 "reflect.h2"
 auto partially_ordered(meta::type_declaration& t) -> void
 {
     ordered_impl(t, "partial_ordering");
 }
 
-#line 636 "reflect.h2"
+#line 639 "reflect.h2"
 auto copyable(meta::type_declaration& t) -> void
 {
     //  If the user explicitly wrote any of the copy/move functions,
@@ -1196,7 +1200,7 @@ auto copyable(meta::type_declaration& t) -> void
     }}
 }
 
-#line 665 "reflect.h2"
+#line 668 "reflect.h2"
 auto basic_value(meta::type_declaration& t) -> void
 {
     CPP2_UFCS_0(copyable, t);
@@ -1216,7 +1220,7 @@ auto basic_value(meta::type_declaration& t) -> void
     }
 }
 
-#line 694 "reflect.h2"
+#line 697 "reflect.h2"
 auto value(meta::type_declaration& t) -> void
 {
     CPP2_UFCS_0(ordered, t);
@@ -1235,7 +1239,7 @@ auto partially_ordered_value(meta::type_declaration& t) -> void
     CPP2_UFCS_0(basic_value, t);
 }
 
-#line 738 "reflect.h2"
+#line 741 "reflect.h2"
 auto cpp2_struct(meta::type_declaration& t) -> void
 {
     for ( auto& m : CPP2_UFCS_0(get_members, t) ) 
@@ -1253,7 +1257,7 @@ auto cpp2_struct(meta::type_declaration& t) -> void
     CPP2_UFCS_0(disable_member_function_generation, t);
 }
 
-#line 818 "reflect.h2"
+#line 821 "reflect.h2"
 }
 }
 
@@ -175,28 +175,8 @@ struct symbol {
 };
 
 
-//  Keep a list of all token*'s found that are definite first uses
-//  of the form "x = expr;" for an uninitialized local variable x,
-//  which we will rewrite to construct the local variable.
-//
-std::vector<token const*> definite_initializations;
-
-auto is_definite_initialization(token const* t)
-    -> bool
-{
-    return
-        std::find(
-            definite_initializations.begin(),
-            definite_initializations.end(),
-            t
-            )
-        != definite_initializations.end();
-}
-
-
-//  Keep a list of all token*'s found that are definite last uses
-//  for a local variable or copy or forward parameter x, which we
-//  will rewrite to move or forward from the variable.
+//  A definite last use of a local variable or copy or forward parameter x,
+//  which we will rewrite to move or forward from the variable.
 //
 struct last_use {
     token const* t;
@@ -210,25 +190,8 @@ struct last_use {
         , is_forward{is_forward_}
     { }
 
-    bool operator==(last_use const& that) { return t == that.t; }
+    bool operator==(last_use const& that) const { return t == that.t; }
 };
-std::vector<last_use> definite_last_uses;
-
-auto is_definite_last_use(token const* t)
-    -> last_use const*
-{
-    auto iter = std::find(
-            definite_last_uses.begin(),
-            definite_last_uses.end(),
-            t
-            );
-    if (iter != definite_last_uses.end()) {
-        return &*iter;
-    }
-    else {
-        return {};
-    }
-}
 
 
 //-----------------------------------------------------------------------
@@ -245,6 +208,18 @@ public:
 
     std::vector<selection_statement_node const*> active_selections;
 
+    //  Keep a list of all token*'s found that are definite first uses
+    //  of the form "x = expr;" for an uninitialized local variable x,
+    //  which we will rewrite to construct the local variable.
+    //
+    std::vector<token const*> definite_initializations;
+
+    //  Keep a list of all token*'s found that are definite last uses
+    //  for a local variable or copy or forward parameter x, which we
+    //  will rewrite to move or forward from the variable.
+    //
+    std::vector<last_use> definite_last_uses;
+
 public:
     //-----------------------------------------------------------------------
     //  Constructor
@@ -258,6 +233,42 @@ public:
     {
     }
 
+
+    //-----------------------------------------------------------------------
+    //  is_definite_initialization: Is t a definite first use "t = expr;"
+    //
+    auto is_definite_initialization(token const* t) const
+        -> bool
+    {
+        return
+            std::find(
+                definite_initializations.begin(),
+                definite_initializations.end(),
+                t
+                )
+            != definite_initializations.end();
+    }
+
+
+    //-----------------------------------------------------------------------
+    //  is_definite_last_use: Is t a definite last use, and if so what kind
+    //
+    auto is_definite_last_use(token const* t) const
+        -> last_use const*
+    {
+        auto iter = std::find(
+                definite_last_uses.begin(),
+                definite_last_uses.end(),
+                t
+                );
+        if (iter != definite_last_uses.end()) {
+            return &*iter;
+        }
+        else {
+            return {};
+        }
+    }
+
     //  Get the declaration of t within the same named function or beyond it
     //
     auto get_declaration_of(
@@ -564,7 +575,7 @@ private:
         token const* id,
         int          pos,
         bool         is_forward
-    ) const
+    )
         -> void
     {
         auto i = pos;
@@ -659,7 +670,7 @@ private:
         declaration_sym const* decl,
         int                    pos,
         int                    depth
-    ) const
+    )
         -> bool
     {
         //  If this is a member variable in a constructor, the name doesn't
@@ -1679,9 +1690,13 @@ public:
         --scope_depth;
     }
 
-    auto start(assignment_expression_node const& n, int)
+    auto start(binary_expression_node const& n, int)
     {
-        if (std::ssize(n.terms) > 0) {
+        if (
+            n.level == precedence_level::assignment
+            && std::ssize(n.terms) > 0
+            )
+        {
             assert (n.terms.front().op);
             if (n.terms.front().op->type() == lexeme::Assignment) {
                 started_assignment_expression = true;